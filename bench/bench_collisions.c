@@ -0,0 +1,179 @@
+// bench_collisions.c
+// handle_collisions con la griglia (a vari lati di cella), con la sweep and prune e con
+// l'albero dinamico contro il doppio ciclo originale: 10k proiettili contro 1k nemici, al
+// variare dell'area occupata. Per l'albero il tempo comprende sync_collision_tree.
+// Ogni ripetizione è il frame successivo del movimento, come nel gioco.
+// make bench && ./build/bench_collisions
+#include "entities.h"
+#include "clock_ms.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPEATS 20
+#define ENEMIES 1000
+#define PROJECTILES 10000
+#define FRAME_TIME (1.0f / 60.0f)
+
+static GameWorld world;
+static Enemy savedEnemies[MAX_ENEMIES];
+static Projectile savedProjectiles[MAX_PROJECTILES];
+static bool bruteEnemies[MAX_ENEMIES];
+static bool bruteProjectiles[MAX_PROJECTILES];
+
+static float frand(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Il doppio ciclo che handle_collisions faceva prima della broadphase
+static void handle_collisions_brute(GameWorld *w)
+{
+    for (int i = 0; i < w->projectile_count; i++)
+    {
+        if (!w->projectiles[i].is_active)
+            continue;
+        for (int j = 0; j < w->enemy_count; j++)
+        {
+            if (!w->enemies[j].is_active)
+                continue;
+            if (check_collision(&w->projectiles[i].transform, &w->enemies[j].transform))
+            {
+                w->projectiles[i].is_active = false;
+                w->enemies[j].is_active = false;
+                break;
+            }
+        }
+    }
+}
+
+// Mondo vuoto con la broadphase scelta, poi nemici e proiettili sempre uguali per area
+static void populate(CollisionBroadphase broadphase, float cellSize, float area)
+{
+    free_game_world(&world);
+    init_game_world(&world, broadphase);
+    world.collision_cell_size = cellSize;
+    srand(1234);
+    for (int j = 0; j < ENEMIES; j++)
+        create_enemy(&world, frand(0.0f, area), frand(0.0f, area));
+    for (int i = 0; i < PROJECTILES; i++)
+    {
+        float angle = frand(0.0f, 6.2831853f);
+        create_projectile(&world, frand(0.0f, area), frand(0.0f, area), cosf(angle), sinf(angle));
+    }
+    memcpy(savedEnemies, world.enemies, sizeof(savedEnemies));
+    memcpy(savedProjectiles, world.projectiles, sizeof(savedProjectiles));
+}
+
+// Stato del frame-esimo passo, senza le disattivazioni dei frame precedenti
+static void restore_frame(int frame)
+{
+    memcpy(world.enemies, savedEnemies, sizeof(savedEnemies));
+    memcpy(world.projectiles, savedProjectiles, sizeof(savedProjectiles));
+    float t = frame * FRAME_TIME;
+    for (int j = 0; j < world.enemy_count; j++)
+        world.enemies[j].transform.x += world.enemies[j].speed * t;
+    for (int i = 0; i < world.projectile_count; i++)
+    {
+        Projectile *p = &world.projectiles[i];
+        p->transform.x += p->direction_x * p->speed * t;
+        p->transform.y += p->direction_y * p->speed * t;
+    }
+}
+
+// Con l'albero la broadphase comprende il suo aggiornamento
+static void handle_collisions_tree(GameWorld *w)
+{
+    sync_collision_tree(w, FRAME_TIME);
+    handle_collisions(w);
+}
+
+// Il minimo sui frame; alla fine il mondo contiene il risultato dell'ultimo
+static double time_collisions(void (*handle)(GameWorld *))
+{
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        restore_frame(r);
+        double t0 = clock_now_ms();
+        handle(&world);
+        double t = clock_now_ms() - t0;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+// Stesse coppie del doppio ciclo, non solo lo stesso numero
+static bool same_as_brute(void)
+{
+    for (int j = 0; j < world.enemy_count; j++)
+    {
+        if (world.enemies[j].is_active != bruteEnemies[j])
+        {
+            fprintf(stderr, "Risultati diversi: nemico %d\n", j);
+            return false;
+        }
+    }
+    for (int i = 0; i < world.projectile_count; i++)
+    {
+        if (world.projectiles[i].is_active != bruteProjectiles[i])
+        {
+            fprintf(stderr, "Risultati diversi: proiettile %d\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    const float areas[] = {1024.0f, 4096.0f, 16384.0f};
+    const float cellSizes[] = {32.0f, 64.0f, 128.0f, 256.0f};
+
+    printf("%8s %12s %6s %12s %12s %8s\n", "area", "broadphase", "hits", "brute ms", "ms", "speedup");
+    for (size_t a = 0; a < sizeof(areas) / sizeof(areas[0]); a++)
+    {
+        populate(COLLISION_GRID, 64.0f, areas[a]);
+        double brute = time_collisions(handle_collisions_brute);
+        int hits = 0;
+        for (int j = 0; j < world.enemy_count; j++)
+        {
+            bruteEnemies[j] = world.enemies[j].is_active;
+            hits += !bruteEnemies[j];
+        }
+        for (int i = 0; i < world.projectile_count; i++)
+            bruteProjectiles[i] = world.projectiles[i].is_active;
+
+        const size_t gridRows = sizeof(cellSizes) / sizeof(cellSizes[0]);
+        for (size_t c = 0; c < gridRows + 2; c++)
+        {
+            char name[32];
+            // Dopo le righe della griglia la sweep and prune e l'albero
+            void (*handle)(GameWorld *) = handle_collisions;
+            if (c < gridRows)
+            {
+                populate(COLLISION_GRID, cellSizes[c], areas[a]);
+                snprintf(name, sizeof(name), "grid %.0f", cellSizes[c]);
+            }
+            else if (c == gridRows)
+            {
+                populate(COLLISION_SWEEP_PRUNE, 64.0f, areas[a]);
+                snprintf(name, sizeof(name), "sweep prune");
+            }
+            else
+            {
+                populate(COLLISION_AABB_TREE, 64.0f, areas[a]);
+                snprintf(name, sizeof(name), "aabb tree");
+                handle = handle_collisions_tree;
+            }
+            double ms = time_collisions(handle);
+            if (!same_as_brute())
+                return 1;
+            printf("%8.0f %12s %6d %12.4f %12.4f %7.2fx\n", areas[a], name, hits, brute, ms, brute / ms);
+        }
+    }
+
+    free_game_world(&world);
+    return 0;
+}
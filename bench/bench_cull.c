@@ -0,0 +1,119 @@
+// bench_cull.c
+// Tempo del gather con culling su CPU al variare del numero di sprite e della frazione visibile.
+// make bench && ./build/bench_cull
+#include "cull.h"
+#include "clock_ms.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPEATS 200
+
+static float frand(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Una frazione visibleFraction degli sprite cade nella vista, gli altri fuori
+static void make_sprites(Sprite *sprites, size_t count, float visibleFraction, const CullView *view)
+{
+    vec2 uv0 = {0.0f, 0.0f};
+    vec2 uv1 = {1.0f, 1.0f};
+    for (size_t i = 0; i < count; i++)
+    {
+        float parallax = (rand() % 2) ? 1.0f : 0.5f;
+        float sx, sy;
+        if (frand(0.0f, 1.0f) < visibleFraction)
+        {
+            sx = frand(0.0f, view->width);
+            sy = frand(0.0f, view->height);
+        }
+        else
+        {
+            sx = frand(view->width + 64.0f, 16384.0f);
+            sy = frand(-16384.0f, 16384.0f);
+        }
+        sprite_init(&sprites[i], sx + view->cameraX * parallax, sy + view->cameraY * parallax, 32.0f, 32.0f,
+                    uv0, uv1, 0.0f, parallax, parallax, parallax);
+        if (rand() % 4 == 0)
+            sprites[i].rotation = frand(0.0f, 6.28f);
+    }
+}
+
+typedef size_t (*CullFunc)(const Sprite *, size_t, const CullView *, uint32_t *);
+
+// Culling + copia dei sopravvissuti, come renderer_set_sprites con RENDERER_CULL_CPU
+static double time_gather(CullFunc cull, const Sprite *sprites, size_t count, const CullView *view,
+                          uint32_t *visible, Sprite *out, size_t *emitted)
+{
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        double t0 = clock_now_ms();
+        size_t n = cull(sprites, count, view, visible);
+        for (size_t i = 0; i < n; i++)
+            out[i] = sprites[visible[i]];
+        double t = clock_now_ms() - t0;
+        if (t < best)
+            best = t;
+        *emitted = n;
+    }
+    return best;
+}
+
+int main(void)
+{
+    const size_t counts[] = {1024, 4096, 16384, 65536};
+    const float fractions[] = {0.01f, 0.1f, 0.5f, 1.0f};
+    const size_t maxCount = counts[sizeof(counts) / sizeof(counts[0]) - 1];
+
+    Sprite *sprites = malloc(maxCount * sizeof(Sprite));
+    Sprite *out = malloc(maxCount * sizeof(Sprite));
+    uint32_t *visible = malloc(maxCount * sizeof(uint32_t));
+    uint32_t *visibleScalar = malloc(maxCount * sizeof(uint32_t));
+    if (!sprites || !out || !visible || !visibleScalar)
+    {
+        fprintf(stderr, "Memoria insufficiente\n");
+        return 1;
+    }
+
+    CullView view = {1000.0f, 500.0f, 960.0f, 540.0f};
+    srand(1234);
+
+    printf("%8s %8s %8s %12s %12s %8s\n", "sprites", "visible", "emitted", "scalar ms", "simd ms", "speedup");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        for (size_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); f++)
+        {
+            size_t count = counts[c];
+            make_sprites(sprites, count, fractions[f], &view);
+
+            size_t emittedScalar, emittedSimd;
+            double scalar =
+                time_gather(cull_sprites_scalar, sprites, count, &view, visibleScalar, out, &emittedScalar);
+            double simd = time_gather(cull_sprites, sprites, count, &view, visible, out, &emittedSimd);
+            if (emittedScalar != emittedSimd)
+            {
+                fprintf(stderr, "Risultati diversi: scalare %zu, SIMD %zu\n", emittedScalar, emittedSimd);
+                return 1;
+            }
+            // Stesso numero non basta: devono essere gli stessi sprite, nello stesso ordine
+            for (size_t i = 0; i < emittedSimd; i++)
+            {
+                if (visibleScalar[i] != visible[i])
+                {
+                    fprintf(stderr, "Visibile %zu diverso: scalare %u, SIMD %u\n", i, visibleScalar[i], visible[i]);
+                    return 1;
+                }
+            }
+            printf("%8zu %7.0f%% %8zu %12.4f %12.4f %7.2fx\n", count, fractions[f] * 100.0f, emittedSimd,
+                   scalar, simd, scalar / simd);
+        }
+    }
+
+    free(sprites);
+    free(out);
+    free(visible);
+    free(visibleScalar);
+    return 0;
+}
@@ -0,0 +1,217 @@
+// bench_movement.c
+// Attori che rimbalzano in una stanza di tile: actor_move_x/y, che salta i tratti liberi,
+// contro il passo di un pixel alla volta del modello Actor/Solid. Le posizioni finali
+// devono coincidere. Prima una piattaforma mossa con solid_move deve trasportare, spingere
+// e schiacciare al pixel.
+// make bench && ./build/bench_movement
+#include "movement.h"
+#include "clock_ms.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ACTORS 4096
+#define FRAMES 120
+#define REPEATS 5
+
+// Il riferimento: ogni pixel dello spostamento controllato a parte
+static int take_pixels(float *remainder, float amount)
+{
+    *remainder += amount;
+    int move = (int)roundf(*remainder);
+    *remainder -= (float)move;
+    return move;
+}
+
+static bool step_x(const MoveContext *context, Actor *actor, float amount)
+{
+    int move = take_pixels(&actor->remainderX, amount);
+    int sign = move > 0 ? 1 : -1;
+    for (; move != 0; move -= sign)
+    {
+        if (actor_collide_at(context, actor, actor->x + sign, actor->y))
+            return false;
+        actor->x += sign;
+    }
+    return true;
+}
+
+static bool step_y(const MoveContext *context, Actor *actor, float amount)
+{
+    int move = take_pixels(&actor->remainderY, amount);
+    int sign = move > 0 ? 1 : -1;
+    for (; move != 0; move -= sign)
+    {
+        if (actor_collide_at(context, actor, actor->x, actor->y + sign))
+            return false;
+        actor->y += sign;
+    }
+    return true;
+}
+
+typedef struct
+{
+    float vx, vy;
+} Velocity;
+
+static float frand(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+// Un frame per tutti gli attori: chi sbatte rimbalza su quell'asse
+static void simulate(const MoveContext *context, Actor *actors, Velocity *velocities, bool stepping)
+{
+    const float dt = 1.0f / 60.0f;
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        for (int i = 0; i < ACTORS; i++)
+        {
+            bool freeX = stepping ? step_x(context, &actors[i], velocities[i].vx * dt)
+                                  : actor_move_x(context, &actors[i], velocities[i].vx * dt);
+            if (!freeX)
+                velocities[i].vx = -velocities[i].vx;
+            bool freeY = stepping ? step_y(context, &actors[i], velocities[i].vy * dt)
+                                  : actor_move_y(context, &actors[i], velocities[i].vy * dt);
+            if (!freeY)
+                velocities[i].vy = -velocities[i].vy;
+        }
+    }
+}
+
+// Una piattaforma con un attore sopra e uno accanto, contro un muro: trasporto, spinta e
+// schiacciamento con un resto di -0.5 che non deve aggiungere pixel
+static bool check_platform(void)
+{
+    Solid solids[2];
+    solid_init(&solids[0], 40.0f, 50.0f, 32, 8); // la piattaforma
+    solid_init(&solids[1], 0.0f, 0.0f, 16, 100); // il muro
+    MoveContext context = {NULL, solids, 2};
+    Solid *platform = &solids[0];
+    Actor rider, pushed;
+    actor_init(&rider, 50.0f, 42.0f, 8, 8);
+    actor_init(&pushed, 30.0f, 50.0f, 8, 8);
+    rider.remainderX = pushed.remainderX = -0.5f;
+    Actor *actors[] = {&rider, &pushed};
+
+    solid_move(&context, platform, 0.0f, -2.0f, actors, 2);
+    if (rider.y != 40 || !actor_is_riding(&rider, platform))
+    {
+        fprintf(stderr, "Piattaforma: l'attore sopra non è salito con lei (y %d)\n", rider.y);
+        return false;
+    }
+    solid_move(&context, platform, -3.0f, 0.0f, actors, 2);
+    if (rider.x != 47 || rider.remainderX != -0.5f)
+    {
+        fprintf(stderr, "Piattaforma: trasportato a x %d invece di 47\n", rider.x);
+        return false;
+    }
+    if (pushed.x + pushed.width != platform->x || pushed.squished)
+    {
+        fprintf(stderr, "Piattaforma: spinto a x %d invece di %d\n", pushed.x, platform->x - pushed.width);
+        return false;
+    }
+    // Contro il muro non c'è spazio: resta attaccato al muro e schiacciato
+    for (int i = 0; i < 3; i++)
+        solid_move(&context, platform, -8.0f, 0.0f, actors, 2);
+    if (!pushed.squished || pushed.x != 16 || rider.squished || rider.x != 23)
+    {
+        fprintf(stderr, "Piattaforma: schiacciamento sbagliato (spinto x %d %d, sopra x %d %d)\n", pushed.x,
+                pushed.squished, rider.x, rider.squished);
+        return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    if (!check_platform())
+        return 1;
+
+    // La stanza di bench_solid_grid chiusa da quattro muri, più due piattaforme ferme
+    TileMap map;
+    SolidGrid grid = {0};
+    if (!tilemap_init(&map, 640, 45, 1, 8, 0.0f))
+        return 1;
+    srand(1234);
+    tilemap_fill(&map, 0, 40, map.width, map.height, 1);
+    tilemap_fill(&map, 0, 0, map.width, 1, 1);
+    tilemap_fill(&map, 0, 0, 1, map.height, 1);
+    tilemap_fill(&map, map.width - 1, 0, map.width, map.height, 1);
+    for (int x = 12; x < map.width; x += 24)
+        tilemap_fill(&map, x, 30, x + 6, 31, 2);
+    for (int i = 0; i < 2000; i++)
+        tilemap_set(&map, rand() % map.width, rand() % map.height, 3);
+    if (!solid_grid_build(&grid, &map))
+        return 1;
+    Solid solids[2];
+    solid_init(&solids[0], 400.0f, 120.0f, 64, 8);
+    solid_init(&solids[1], 2400.0f, 200.0f, 96, 16);
+    MoveContext context = {&grid, solids, 2};
+
+    Actor *start = malloc(ACTORS * sizeof(Actor));
+    Actor *actors = malloc(ACTORS * sizeof(Actor));
+    Velocity *startVelocities = malloc(ACTORS * sizeof(Velocity));
+    Velocity *velocities = malloc(ACTORS * sizeof(Velocity));
+    if (!start || !actors || !startVelocities || !velocities)
+    {
+        fprintf(stderr, "Memoria insufficiente\n");
+        return 1;
+    }
+    // Attori da 8x8 a 32x32, da fermi fino a 600 unità al secondo. Quasi tutti partono in
+    // punti liberi; uno su otto parte dentro un solido, dove il passo rifiuta ogni pixel
+    for (int i = 0; i < ACTORS; i++)
+    {
+        int size = 8 << (rand() % 3);
+        bool embedded = i % 8 == 0;
+        do
+            actor_init(&start[i], frand(0.0f, map.width * 8.0f), frand(0.0f, map.height * 8.0f), size, size);
+        while (actor_collide_at(&context, &start[i], start[i].x, start[i].y) != embedded);
+        float angle = frand(0.0f, 6.2831853f), speed = frand(0.0f, 600.0f);
+        startVelocities[i] = (Velocity){cosf(angle) * speed, sinf(angle) * speed};
+    }
+
+    printf("%9s %12s %12s %8s\n", "actors", "step ms", "sweep ms", "speedup");
+    double best[2] = {1e30, 1e30};
+    Actor *results[2] = {malloc(ACTORS * sizeof(Actor)), malloc(ACTORS * sizeof(Actor))};
+    if (!results[0] || !results[1])
+    {
+        fprintf(stderr, "Memoria insufficiente\n");
+        return 1;
+    }
+    for (int r = 0; r < REPEATS; r++)
+    {
+        for (int mode = 0; mode < 2; mode++)
+        {
+            memcpy(actors, start, ACTORS * sizeof(Actor));
+            memcpy(velocities, startVelocities, ACTORS * sizeof(Velocity));
+            double t0 = clock_now_ms();
+            simulate(&context, actors, velocities, mode == 0);
+            double t1 = clock_now_ms();
+            if (t1 - t0 < best[mode])
+                best[mode] = t1 - t0;
+            memcpy(results[mode], actors, ACTORS * sizeof(Actor));
+        }
+    }
+    for (int i = 0; i < ACTORS; i++)
+    {
+        if (results[0][i].x != results[1][i].x || results[0][i].y != results[1][i].y)
+        {
+            fprintf(stderr, "Attore %d diverso: passo (%d, %d), salto (%d, %d)\n", i, results[0][i].x,
+                    results[0][i].y, results[1][i].x, results[1][i].y);
+            return 1;
+        }
+    }
+    printf("%9d %12.4f %12.4f %7.2fx\n", ACTORS, best[0], best[1], best[0] / best[1]);
+
+    free(results[0]);
+    free(results[1]);
+    free(velocities);
+    free(startVelocities);
+    free(actors);
+    free(start);
+    solid_grid_free(&grid);
+    tilemap_free(&map);
+    return 0;
+}
@@ -0,0 +1,137 @@
+// bench_solid_grid.c
+// Test attore-solidi su una stanza di tile: tilemap_get tile per tile contro le righe di bit
+// di SolidGrid, per rettangoli da attore fino a una striscia larga. Ogni rettangolo deve dare
+// lo stesso test e lo stesso conteggio della tilemap, anche a cavallo di parole e bordi.
+// make bench && ./build/bench_solid_grid
+#include "solid_grid.h"
+#include "clock_ms.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPEATS 20
+#define PROBES 100000
+
+// Tile coperti dal rettangolo in pixel, arrotondando verso il basso anche fuori dalla mappa
+static int tile_floor(int pixel)
+{
+    return pixel >= 0 ? pixel / SOLID_GRID_TILE_PIXELS : -((-pixel + 7) / SOLID_GRID_TILE_PIXELS);
+}
+
+// Il test senza bitset: ogni tile coperto dal rettangolo letto dalla tilemap
+static bool collide_rect_tiles(const TileMap *map, int x, int y, int w, int h)
+{
+    for (int ty = tile_floor(y); ty <= tile_floor(y + h - 1); ty++)
+        for (int tx = tile_floor(x); tx <= tile_floor(x + w - 1); tx++)
+            if (tilemap_get(map, tx, ty) != TILEMAP_EMPTY)
+                return true;
+    return false;
+}
+
+static int count_rect_tiles(const TileMap *map, int x, int y, int w, int h)
+{
+    int count = 0;
+    for (int ty = tile_floor(y); ty <= tile_floor(y + h - 1); ty++)
+        for (int tx = tile_floor(x); tx <= tile_floor(x + w - 1); tx++)
+            count += tilemap_get(map, tx, ty) != TILEMAP_EMPTY;
+    return count;
+}
+
+// Ogni rettangolo da solo, non la somma dei risultati: test e conteggio come la tilemap
+static bool same_as_tiles(const SolidGrid *grid, const TileMap *map, int x, int y, int w, int h)
+{
+    bool hit = solid_grid_collide_rect(grid, x, y, w, h);
+    int count = solid_grid_count_rect(grid, x, y, w, h);
+    if (hit == collide_rect_tiles(map, x, y, w, h) && count == count_rect_tiles(map, x, y, w, h))
+        return true;
+    fprintf(stderr, "Rettangolo (%d, %d) %dx%d diverso: tile %d/%d, bit %d/%d\n", x, y, w, h,
+            collide_rect_tiles(map, x, y, w, h), count_rect_tiles(map, x, y, w, h), hit, count);
+    return false;
+}
+
+typedef struct
+{
+    int x, y;
+} Probe;
+
+int main(void)
+{
+    // Stanza come quella di prova, più larga: pavimento, piattaforme e qualche blocco sparso
+    TileMap map;
+    SolidGrid grid = {0};
+    if (!tilemap_init(&map, 640, 45, 1, 8, 0.0f))
+        return 1;
+    srand(1234);
+    tilemap_fill(&map, 0, 40, map.width, map.height, 1);
+    for (int x = 12; x < map.width; x += 24)
+        tilemap_fill(&map, x, 30, x + 6, 31, 2);
+    for (int i = 0; i < 2000; i++)
+        tilemap_set(&map, rand() % map.width, rand() % map.height, 3);
+    if (!solid_grid_build(&grid, &map))
+        return 1;
+
+    Probe *probes = malloc(PROBES * sizeof(Probe));
+    if (!probes)
+    {
+        fprintf(stderr, "Memoria insufficiente\n");
+        return 1;
+    }
+    for (int i = 0; i < PROBES; i++)
+        probes[i] = (Probe){rand() % (map.width * 8 + 64) - 32, rand() % (map.height * 8 + 64) - 32};
+
+    const int sizes[][2] = {{8, 8}, {8, 11}, {16, 24}, {32, 32}, {256, 16}};
+    printf("%9s %8s %12s %12s %8s\n", "rect", "hits", "tiles ms", "bits ms", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int w = sizes[s][0], h = sizes[s][1];
+        double bestTiles = 1e30, bestBits = 1e30;
+        int hitsTiles = 0, hitsBits = 0;
+        for (int r = 0; r < REPEATS; r++)
+        {
+            double t0 = clock_now_ms();
+            hitsTiles = 0;
+            for (int i = 0; i < PROBES; i++)
+                hitsTiles += collide_rect_tiles(&map, probes[i].x, probes[i].y, w, h);
+            double t1 = clock_now_ms();
+            hitsBits = 0;
+            for (int i = 0; i < PROBES; i++)
+                hitsBits += solid_grid_collide_rect(&grid, probes[i].x, probes[i].y, w, h);
+            double t2 = clock_now_ms();
+            if (t1 - t0 < bestTiles)
+                bestTiles = t1 - t0;
+            if (t2 - t1 < bestBits)
+                bestBits = t2 - t1;
+        }
+        for (int i = 0; i < PROBES; i++)
+            if (!same_as_tiles(&grid, &map, probes[i].x, probes[i].y, w, h))
+                return 1;
+        char name[16];
+        snprintf(name, sizeof(name), "%dx%d", w, h);
+        printf("%9s %8d %12.4f %12.4f %7.2fx\n", name, hitsBits, bestTiles, bestBits, bestTiles / bestBits);
+    }
+
+    // Rettangoli a cavallo delle parole da 64 tile e dei bordi della mappa, dentro e fuori
+    const int columns[] = {0, 63, 64, 127, 128, 191, 575, 576, 639};
+    const int offsets[] = {-9, -1, 0, 1, 7};
+    const int rows[] = {-8, -1, 0, 29, 39, 44};
+    const int widths[] = {1, 8, 9, 64 * 8, 65 * 8 + 3, 130 * 8, 700 * 8};
+    const int heights[] = {1, 8, 17, 48 * 8};
+    int edges = 0;
+    for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++)
+        for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++)
+            for (size_t r = 0; r < sizeof(rows) / sizeof(rows[0]); r++)
+                for (size_t wi = 0; wi < sizeof(widths) / sizeof(widths[0]); wi++)
+                    for (size_t hi = 0; hi < sizeof(heights) / sizeof(heights[0]); hi++)
+                    {
+                        int x = columns[c] * SOLID_GRID_TILE_PIXELS + offsets[o];
+                        int y = rows[r] * SOLID_GRID_TILE_PIXELS + offsets[o];
+                        if (!same_as_tiles(&grid, &map, x, y, widths[wi], heights[hi]))
+                            return 1;
+                        edges++;
+                    }
+    printf("%d rettangoli ai bordi uguali alla tilemap\n", edges);
+
+    free(probes);
+    solid_grid_free(&grid);
+    tilemap_free(&map);
+    return 0;
+}
@@ -0,0 +1,141 @@
+// bench_vertex_pulling.c
+// A/B del quad con VBO (6 vertici, attributi per vertice) contro il vertex pulling
+// (triangle strip da 4 vertici generati da gl_VertexID) sullo stesso set di sprite.
+// make bench && ./build/bench_vertex_pulling   (da lanciare nella root del progetto, per shaders/ e assets/)
+// Con --headless (o MYGAME_HEADLESS=1) gira senza display su un contesto EGL offscreen.
+#include "game.h"
+#include "clock_ms.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define WARMUP_FRAMES 20
+#define MEASURED_FRAMES 200
+#define DRAWS_PER_FRAME 8 // ogni frame ridisegna le decorazioni più volte per caricare i vertici
+
+// Griglia di sprite piccoli e opachi che copre tutta la vista
+static void fill_world(GameWorld *world)
+{
+    memset(world, 0, sizeof(GameWorld));
+    vec2 uvStart = {0.0f, 0.0f};
+    vec2 uvEnd = {1.0f / 8.0f, 1.0f / 8.0f};
+    size_t columns = 128;
+    for (size_t i = 0; i < MAX_STATIC_OBJECTS; i++)
+    {
+        float x = 4.0f + (float)(i % columns) * 5.0f;
+        float y = 4.0f + (float)(i / columns) * 5.0f;
+        sprite_init(&world->decorazioni[i], x, y, 8.0f, 8.0f, uvStart, uvEnd, 1.0f, 1.0f, 1.0f, 1.0f);
+        world->decorazioni[i].color[0] = world->decorazioni[i].color[1] = world->decorazioni[i].color[2] = 1.0f;
+    }
+    world->count_decorazioni = MAX_STATIC_OBJECTS;
+}
+
+static int run(const char *name, unsigned flags)
+{
+    Renderer renderer;
+    memset(&renderer, 0, sizeof(renderer));
+    if (!renderer_init(&renderer, 16384, BENCH_WIDTH, BENCH_HEIGHT, flags, NULL))
+    {
+        fprintf(stderr, "%s: renderer_init fallito\n", name);
+        return 0;
+    }
+    renderer.cullMode = RENDERER_CULL_NONE; // si misura solo il lavoro sui vertici
+
+    fill_world(&game.world);
+    mark_decorazioni_dirty(&game.world, 0, game.world.count_decorazioni);
+
+    GLuint query;
+    glGenQueries(1, &query);
+    double gpuTotal = 0.0;
+    double cpuTotal = 0.0;
+
+    for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++)
+    {
+        double t0 = clock_now_ms();
+        renderer_begin_frame(&renderer);
+        renderer_sync_static(&renderer, &game.world);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (int d = 0; d < DRAWS_PER_FRAME; d++)
+        {
+            renderer_draw_pass(&renderer, RENDER_PASS_OPAQUE);
+            renderer_draw_pass(&renderer, RENDER_PASS_TRANSLUCENT);
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        renderer_end_frame(&renderer);
+        glFinish();
+        double t1 = clock_now_ms();
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        if (frame >= WARMUP_FRAMES)
+        {
+            gpuTotal += elapsed / 1.0e6;
+            cpuTotal += t1 - t0;
+        }
+    }
+
+    size_t instances = game.world.count_decorazioni * DRAWS_PER_FRAME;
+    printf("%-16s %9zu instances/frame  GPU %8.3f ms  frame %8.3f ms\n", name, instances,
+           gpuTotal / MEASURED_FRAMES, cpuTotal / MEASURED_FRAMES);
+
+    glDeleteQueries(1, &query);
+    renderer_cleanup(&renderer);
+    return 1;
+}
+
+static GLFWwindow *open_window(void)
+{
+    if (!glfwInit())
+        return NULL;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_DEPTH_BITS, 24);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(BENCH_WIDTH, BENCH_HEIGHT, "bench_vertex_pulling", NULL, NULL);
+    if (!window)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return NULL;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        fprintf(stderr, "Failed to initialize GLAD\n");
+        glfwTerminate();
+        return NULL;
+    }
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+    glfwSwapInterval(0);
+    return window;
+}
+
+int main(int argc, char **argv)
+{
+    const char *env = getenv("MYGAME_HEADLESS");
+    bool headless = (env && env[0] && strcmp(env, "0") != 0) || (argc > 1 && strcmp(argv[1], "--headless") == 0);
+    HeadlessContext offscreen;
+    GLFWwindow *window = NULL;
+    if (headless ? !headless_init(&offscreen, BENCH_WIDTH, BENCH_HEIGHT) : !(window = open_window()))
+        return 1;
+
+    printf("%s\n", (const char *)glGetString(GL_RENDERER));
+    int ok = run("quad VBO", 0) &&
+             run("vertex pulling", RENDERER_VERTEX_PULLING) &&
+             run("quad VBO packed", RENDERER_PACKED_INSTANCES) &&
+             run("pulling packed", RENDERER_VERTEX_PULLING | RENDERER_PACKED_INSTANCES);
+
+    if (headless)
+    {
+        headless_free(&offscreen);
+    }
+    else
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return ok ? 0 : 1;
+}
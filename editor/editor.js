@@ -13,12 +13,14 @@ document.addEventListener('DOMContentLoaded', async () => {
     let rotazioneCorrente = 0;
 
 
-    const NUM_ATLAS = 1;
+    let NUM_ATLAS = 1;
 
-    const atlas = [
+    // sostituiti da loadPackedAtlas se esiste l'atlas di tools/atlas_pack
+    let atlas = [
         // atlas 0
         [[0, 0, 16, 16], [16, 0, 16, 16], [32, 0, 16, 16]]
     ];
+    let atlasImages = ['test.png'];
     const grid = [];
     const images = [];
     let isDraggingH = false;
@@ -153,6 +155,28 @@ document.addEventListener('DOMContentLoaded', async () => {
         alert(n);
     }
 
+    // atlas.json di tools/atlas_pack: regioni per nome -> [layer, x, y, w, h]
+    async function loadPackedAtlas() {
+        let manifest;
+        try {
+            const res = await fetch('../assets/atlas/atlas.json');
+            if (!res.ok) return;
+            manifest = await res.json();
+        } catch (e) {
+            return;
+        }
+        NUM_ATLAS = manifest.layers;
+        atlas = [];
+        atlasImages = [];
+        for (let i = 0; i < NUM_ATLAS; i++) {
+            atlas.push([]);
+            atlasImages.push('../assets/atlas/layer_' + i + '.png');
+        }
+        for (const [name, [layer, x, y, w, h]] of Object.entries(manifest.regions)) {
+            atlas[layer].push([x, y, w, h]);
+        }
+    }
+
     async function init() {
 
         app = new PIXI.Application();
@@ -168,8 +192,9 @@ document.addEventListener('DOMContentLoaded', async () => {
         preview = new PIXI.Container();
         app.stage.addChild(container);
         app.stage.addChild(preview);
+        await loadPackedAtlas();
         for (let i = 0; i < NUM_ATLAS; i++) {
-            images[i] = await PIXI.Assets.load('test.png');
+            images[i] = await PIXI.Assets.load(atlasImages[i]);
             // creo il pulsante di selezione
             const puls = document.createElement("div");
             puls.textContent = i;
@@ -179,7 +204,8 @@ document.addEventListener('DOMContentLoaded', async () => {
 
 
 
-        const rect = new PIXI.Rectangle(0, 0, 16, 16);
+        const [x, y, w, h] = atlas[currAtlas][0] || [0, 0, 16, 16];
+        const rect = new PIXI.Rectangle(x, y, w, h);
 
         texture = new PIXI.Texture({ source: images[currAtlas], frame: rect });
         previewSprite = new PIXI.Sprite(texture);
@@ -0,0 +1,85 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Dynamic bounding-volume tree of axis-aligned boxes, for a mix of static and moving
+// proxies of very different sizes. Leaves store a fattened box (margin plus the
+// predicted displacement), so a proxy that moves a little is not reinserted.
+// Insertion picks the sibling with the lowest perimeter cost (the 2D surface area
+// heuristic) and AVL-style rotations keep the tree balanced on the way up.
+// Nodes live in one growable array and link by index; freed nodes are reused.
+#define AABB_TREE_NULL (-1)
+
+typedef struct
+{
+    float minX, minY, maxX, maxY;
+} Aabb;
+
+typedef struct
+{
+    Aabb box;             // fattened for leaves, union of the children otherwise
+    int parent;           // next free node while the node is free
+    int child1, child2;   // AABB_TREE_NULL for leaves
+    int height;           // 0 for leaves, -1 for free nodes
+    uint32_t category;    // union of the leaves below: queries skip subtrees without their categories
+    int user;             // leaves only: caller data, e.g. the index of the entity
+} AabbNode;
+
+typedef struct
+{
+    AabbNode *nodes;
+    int nodeCount, nodeCapacity;
+    int root;
+    int freeList;
+    float margin;         // world units added around every leaf
+    int *stack;           // traversal scratch
+    int stackCapacity;
+} AabbTree;
+
+// Return false to stop the query
+typedef bool (*AabbTreeQueryCallback)(void *context, int proxy);
+// Called for each leaf whose fat box the segment crosses before maxFraction. Return 0 to
+// stop, a fraction in (0, maxFraction) to clip the segment there (a hit), a negative
+// value or maxFraction to ignore the proxy.
+typedef float (*AabbTreeRayCallback)(void *context, int proxy, float x0, float y0, float x1, float y1,
+                                     float maxFraction);
+
+void aabb_tree_init(AabbTree *tree, float margin);
+void aabb_tree_free(AabbTree *tree);
+// Returns the proxy, AABB_TREE_NULL if out of memory
+int aabb_tree_create_proxy(AabbTree *tree, float x, float y, float width, float height, uint32_t category, int user);
+void aabb_tree_destroy_proxy(AabbTree *tree, int proxy);
+// (dx, dy) is the expected displacement until the next move, used to fatten the box
+// ahead of the motion. Returns true if the proxy was reinserted.
+bool aabb_tree_move_proxy(AabbTree *tree, int proxy, float x, float y, float width, float height, float dx,
+                          float dy);
+// Leaves whose category is in categories and whose fat box overlaps the query
+void aabb_tree_query_box(AabbTree *tree, float x, float y, float width, float height, uint32_t categories,
+                         AabbTreeQueryCallback callback, void *context);
+void aabb_tree_query_point(AabbTree *tree, float x, float y, uint32_t categories, AabbTreeQueryCallback callback,
+                           void *context);
+// Segment from (x0, y0) to (x1, y1)
+void aabb_tree_ray_cast(AabbTree *tree, float x0, float y0, float x1, float y1, uint32_t categories,
+                        AabbTreeRayCallback callback, void *context);
+int aabb_tree_height(const AabbTree *tree);
+// Where the segment enters the box, as a fraction of its length (0 if it starts inside)
+bool aabb_segment_fraction(const Aabb *box, float x0, float y0, float x1, float y1, float *fraction);
+
+static inline int aabb_tree_user(const AabbTree *tree, int proxy)
+{
+    return tree->nodes[proxy].user;
+}
+
+static inline void aabb_tree_set_user(AabbTree *tree, int proxy, int user)
+{
+    tree->nodes[proxy].user = user;
+}
+
+static inline uint32_t aabb_tree_category(const AabbTree *tree, int proxy)
+{
+    return tree->nodes[proxy].category;
+}
+
+#endif // AABB_TREE_H
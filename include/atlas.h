@@ -0,0 +1,68 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sprite.h"
+
+// Binary manifest written by tools/atlas_pack (little-endian):
+//   AtlasHeader, then regionCount AtlasRegion records sorted by name.
+// Layer n of the texture array is the PNG next to the manifest, see atlas_layer_path.
+#define ATLAS_MAGIC 0x534C5441u // "ATLS"
+#define ATLAS_VERSION 3
+#define ATLAS_NAME_LENGTH 48
+#define ATLAS_DEFAULT_PATH "assets/atlas/atlas.bin"
+#define ATLAS_REGION_OPAQUE 1u // every texel of the source image has alpha 255
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layerWidth, layerHeight;
+    uint32_t layerCount;
+    uint32_t regionCount;
+    uint32_t padding;             // replicated edge texels around every region
+} AtlasHeader;
+
+typedef struct
+{
+    char name[ATLAS_NAME_LENGTH]; // source file name without extension, NUL-terminated
+    uint16_t layer;
+    uint16_t x, y;                // top-left pixel inside the layer
+    uint16_t width, height;
+    uint16_t flags;               // ATLAS_REGION_*
+    uint16_t reserved[2];
+} AtlasRegion;                    // Total: 64 bytes
+
+typedef struct
+{
+    uint64_t corner; // layer << 32 | y << 16 | x of the region's top-left pixel
+    uint32_t region; // index into Atlas.regions
+} AtlasCorner;
+
+typedef struct
+{
+    uint32_t layerWidth, layerHeight;
+    uint32_t layerCount;
+    uint32_t regionCount;
+    uint32_t padding;
+    AtlasRegion *regions;
+    AtlasCorner *corners; // sorted by corner in atlas_load, for atlas_find_uv
+} Atlas;
+
+bool atlas_load(Atlas *atlas, const char *path);
+bool atlas_save(Atlas *atlas, const char *path); // sorts the regions by name first
+void atlas_free(Atlas *atlas);
+void atlas_layer_path(const char *manifestPath, int layer, char *out, size_t size);
+// Mip levels a page can have without regions bleeding into each other: level k averages
+// 2^k texels, which stay inside the padding while 2^k <= padding
+int atlas_mip_levels(const Atlas *atlas);
+const AtlasRegion *atlas_find(const Atlas *atlas, const char *name); // binary search, NULL if missing
+// The region a sprite samples: its uvStart is the region's top-left corner and uvEnd lies
+// inside the region. NULL if there is none (e.g. a rectangle spanning two regions).
+const AtlasRegion *atlas_find_uv(const Atlas *atlas, int layer, const vec2 uvStart, const vec2 uvEnd);
+// Points the sprite at a region: uvStart/uvEnd and layerIndex. False if the name is unknown.
+bool sprite_set_region(Sprite *sprite, const Atlas *atlas, const char *name);
+
+#endif // ATLAS_H
@@ -0,0 +1,15 @@
+#ifndef CLOCK_MS_H
+#define CLOCK_MS_H
+
+#include <time.h>
+
+// CLOCK_MONOTONIC in milliseconds: startup timings, the profiler, headless pacing and
+// the benchmarks all read the same clock
+static inline double clock_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+#endif // CLOCK_MS_H
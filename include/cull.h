@@ -0,0 +1,25 @@
+#ifndef CULL_H
+#define CULL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sprite.h"
+
+// Visible rectangle in world units: [0, width] x [0, height] once each sprite is
+// offset by cameraPos * parallaxFactor, the same math as shaders/sprite.vert
+typedef struct
+{
+    float cameraX, cameraY;
+    float width, height;
+} CullView;
+
+// Writes the indices of the sprites overlapping the view into visible and returns
+// how many there are. Rotated sprites are tested with the circle enclosing the quad,
+// so the CPU test is conservative where sprite_cull.comp is exact.
+// Picks the AVX2 or SSE kernel at runtime (8 sprites per iteration), scalar elsewhere.
+size_t cull_sprites(const Sprite *sprites, size_t count, const CullView *view, uint32_t *visible);
+size_t cull_sprites_scalar(const Sprite *sprites, size_t count, const CullView *view, uint32_t *visible);
+bool cull_sprite_visible(const Sprite *sprite, const CullView *view);
+
+#endif // CULL_H
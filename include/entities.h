@@ -6,10 +6,32 @@
 #include <math.h>
 #include <linmath.h>
 #include <sprite.h>
+#include "tilemap.h"
+#include "spatial_grid.h"
+#include "sweep_prune.h"
+#include "aabb_tree.h"
+#include "solid_grid.h"
+#include "movement.h"
  
-#define MAX_ENEMIES 50
-#define MAX_PROJECTILES 100
+#define MAX_ENEMIES 1024
+#define MAX_PROJECTILES 16384
 #define MAX_STATIC_OBJECTS 8192
+#define MAX_PLATFORMS 64
+
+// Broadphase di handle_collisions, scelta in init_game_world
+typedef enum {
+    COLLISION_GRID,        // griglia uniforme ricostruita a ogni tick
+    COLLISION_SWEEP_PRUNE, // sweep and prune persistente, per movimenti coerenti
+    COLLISION_AABB_TREE,   // query sull'albero dinamico della GameWorld
+} CollisionBroadphase;
+
+// Categorie dei proxy della sweep and prune e dell'albero dinamico
+#define COLLISION_ENEMY (1u << 0)
+#define COLLISION_PROJECTILE (1u << 1)
+#define COLLISION_SOLID (1u << 2) // decorazioni sul piano di gioco (parallasse 1)
+
+// Margine dei box grassi dell'albero, in unità del mondo
+#define COLLISION_TREE_MARGIN 4.0f
 
 typedef struct {
     float x, y;
@@ -31,6 +53,9 @@ typedef struct {
     float patrol_range;
     float patrol_start_x;
     bool is_active;
+    Actor body; // posizione al pixel contro i solidi, transform la segue
+    int proxy; // nella sweep and prune, -1 con la griglia
+    int tree_proxy;
     // Aggiungi altri attributi specifici del nemico
 } Enemy;
 
@@ -41,12 +66,21 @@ typedef struct {
     float direction_y;
     int damage;
     bool is_active;
+    Actor body;
+    int proxy; // nella sweep and prune, -1 con la griglia
+    int tree_proxy;
     // Aggiungi altri attributi specifici del proiettile
 } Projectile;
 
 typedef Sprite EntitaStatica;
 
 
+// Risultato delle query sulla GameWorld: index è nell'array della categoria
+typedef struct {
+    uint32_t category; // COLLISION_ENEMY, COLLISION_PROJECTILE o COLLISION_SOLID
+    int index;
+} WorldHit;
+
 // possiamo utilizzare un unico array per gli sprite
 // e poi un array diverso per ciascun tipo oggetto
 // gli oggetti memorizzano l'indice al relativo sprite nell'array per poterlo modificare quando serve
@@ -64,26 +98,66 @@ typedef struct {
 
     EntitaStatica decorazioni[MAX_STATIC_OBJECTS];
     size_t count_decorazioni;
+    // intervallo [dirty_begin, dirty_end) di decorazioni modificate dall'ultimo upload sulla GPU
+    size_t decorazioni_dirty_begin;
+    size_t decorazioni_dirty_end;
+    int decorazioni_proxy[MAX_STATIC_OBJECTS]; // nell'albero, -1 se non è un solido
+
+    TileMap tilemap; // geometria della stanza
+    SolidGrid solids; // tile pieni della tilemap, per i test al pixel di attori e solidi
+    Solid platforms[MAX_PLATFORMS]; // solidi mobili: spingono e trasportano nemici e proiettili
+    int platform_count;
+    Actor *platform_actors[MAX_ENEMIES + MAX_PROJECTILES]; // scratch di move_platform
+    CollisionBroadphase broadphase;
+    float collision_cell_size; // lato delle celle della broadphase, scelto per stanza
+    SpatialGrid enemy_grid;    // nemici attivi, ricostruita a ogni handle_collisions
+    SweepPrune sweep_prune;    // un proxy per nemico e per proiettile
+    uint64_t *collision_hits;  // coppie proiettile << 32 | nemico della sweep and prune
+    int collision_hit_capacity;
+    AabbTree collision_tree;   // solidi, nemici e proiettili, per collisioni e trigger
+    bool collision_tree_stale; // nemici e proiettili mossi dopo l'ultimo sync_collision_tree
+    float collision_tree_dt;   // delta_time con cui sincronizzarlo
    
 } GameWorld;
 
 
 
 // Funzioni di inizializzazione
-void init_game_world(GameWorld* world);
+void init_game_world(GameWorld* world, CollisionBroadphase broadphase);
 Player* create_player(GameWorld* world, float x, float y);
 Enemy* create_enemy(GameWorld* world, float x, float y);
 Projectile* create_projectile(GameWorld* world, float x, float y, float dir_x, float dir_y);
+Solid* create_platform(GameWorld* world, float x, float y, int width, int height);
+void mark_decorazioni_dirty(GameWorld* world, size_t first, size_t count);
+void free_game_world(GameWorld* world);
 
 // Funzioni di update
 void update_player(Player* player, float delta_time);
-void update_enemy(Enemy* enemy, float delta_time);
-void update_projectile(Projectile* projectile, float delta_time);
+// Nemici e proiettili si muovono al pixel e si fermano contro tile e piattaforme
+void update_enemy(GameWorld* world, Enemy* enemy, float delta_time);
+void update_projectile(GameWorld* world, Projectile* projectile, float delta_time);
+// Sposta la piattaforma portandosi dietro chi ci sta sopra; chi resta schiacciato muore
+void move_platform(GameWorld* world, Solid* platform, float dx, float dy);
 void update_game_world(GameWorld* world, float delta_time);
 
 // Funzioni di collisione
 bool check_collision(Transform* a, Transform* b);
 void handle_collisions(GameWorld* world);
+// Il rettangolo in pixel [x, x + w) x [y, y + h) tocca un tile pieno della stanza?
+bool collide_rect(const GameWorld* world, int x, int y, int w, int h);
+// Porta nell'albero le posizioni di nemici e proiettili. update_game_world la chiama prima
+// di handle_collisions solo con COLLISION_AABB_TREE; con le altre broadphase la chiamano le
+// query al primo uso dopo l'update. Chi sposta le entità altrove la chiama prima delle query
+void sync_collision_tree(GameWorld* world, float delta_time);
+// Query sull'albero, filtrate per categoria, esatte sui box di nemici, proiettili e
+// decorazioni dritte; una decorazione ruotata è il quadrato che contiene il suo cerchio,
+// quindi può risultare colpita anche fuori dal rettangolo orientato. Restituiscono quanti
+// risultati ci sono in tutto, anche oltre max
+int query_world_box(GameWorld* world, const Transform* box, uint32_t categories, WorldHit* out, int max);
+int query_world_point(GameWorld* world, float x, float y, uint32_t categories, WorldHit* out, int max);
+// Il primo box colpito dal segmento: fraction è la frazione del segmento dove entra
+bool raycast_world(GameWorld* world, float x0, float y0, float x1, float y1, uint32_t categories, WorldHit* hit,
+                   float* fraction);
 
 // Funzioni di pulizia
 void remove_inactive_entities(GameWorld* world);
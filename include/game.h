@@ -8,6 +8,7 @@
 #include "linmath.h"
 #include "entities.h"
 #include "renderer.h"
+#include "headless.h"
 
 // Definizione dell'enumerazione GameState
 typedef enum
@@ -25,6 +26,15 @@ typedef struct
     int screenWidth;
     int screenHeight;
     GLFWwindow *window;
+    bool headless;               // --headless or MYGAME_HEADLESS: offscreen EGL context, no window
+    HeadlessContext offscreen;
+    int frameLimit;              // --frames N: stop after N frames, 0 = until ESC
+    int frameCount;
+    const char *screenshotPath;  // --screenshot file.ppm: headless, last frame saved on exit
+    bool profile;                // --profile: CPU/GPU frame breakdown, summary on exit
+    const char *profileCsvPath;  // --profile-csv file.csv: also one row per frame
+    Profiler profiler;
+    CollisionBroadphase broadphase; // --sweep-prune or --aabb-tree, else the uniform grid
     bool running;
     vec2 camera_pos;
     GameWorld world;
@@ -34,9 +44,11 @@ typedef struct
 
 extern Game game;
 
-bool init_game();
+bool init_game(int argc, char **argv);
 void update(float deltaTime);
 void render();
+double game_time(void);     // seconds, monotonic; headless advances 1/60 per frame
+void present_frame(void);   // swaps (or ends the offscreen frame) and polls input
 void cleanup();
 
 #endif
\ No newline at end of file
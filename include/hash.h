@@ -0,0 +1,22 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FNV-1a 64, incremental: start from HASH_FNV1A_SEED and feed the data in any number
+// of pieces. Keys the texture and shader caches.
+#define HASH_FNV1A_SEED 0xCBF29CE484222325ull
+
+static inline uint64_t hash_fnv1a(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#endif // HASH_H
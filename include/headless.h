@@ -0,0 +1,26 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <stdbool.h>
+
+// OpenGL 4.3 core context without a window, for machines with no display (Mesa llvmpipe
+// included): surfaceless EGL (EGL_MESA_platform_surfaceless, else the default display)
+// plus an offscreen framebuffer standing in for the window's. headless_init leaves the
+// context current, glad loaded and the framebuffer bound, so renderer_init draws into it.
+typedef struct
+{
+    EGLDisplay display;
+    EGLContext context;
+    GLuint framebuffer;
+    GLuint color, depth; // renderbuffers of framebuffer
+    int width, height;
+} HeadlessContext;
+
+bool headless_init(HeadlessContext *headless, int width, int height);
+// Writes the framebuffer as a binary PPM (top row first)
+bool headless_save_ppm(const HeadlessContext *headless, const char *path);
+void headless_free(HeadlessContext *headless);
+
+#endif // HEADLESS_H
@@ -0,0 +1,51 @@
+#ifndef MOVEMENT_H
+#define MOVEMENT_H
+
+#include <stdbool.h>
+#include "solid_grid.h"
+
+// Integer-pixel movement in the Actor/Solid model. Positions are whole pixels; the
+// fraction of a move that does not make a whole pixel stays in a per-axis remainder
+// and carries over to the next move, so motion is exact and deterministic.
+// Actors stop at solids (the room's tiles and the collidable Solids); Solids ignore
+// everything, push the actors in their way and carry the actors riding them.
+// A move whose swept rectangle is free jumps straight to the end; only a move that
+// may hit something, or that starts inside a solid, steps one pixel at a time.
+typedef struct
+{
+    int x, y, width, height;
+    float remainderX, remainderY;
+    bool riding;   // scratch of solid_move
+    bool squished; // set when a Solid pushed the actor into something else
+} Actor;
+
+typedef struct
+{
+    int x, y, width, height;
+    float remainderX, remainderY;
+    bool collidable; // false while it moves, so the actors it pushes ignore it
+} Solid;
+
+typedef struct
+{
+    const SolidGrid *tiles;
+    const Solid *solids;
+    int solidCount;
+} MoveContext;
+
+void actor_init(Actor *actor, float x, float y, int width, int height); // rounds to whole pixels
+void solid_init(Solid *solid, float x, float y, int width, int height);
+// Would the actor overlap a tile or a collidable Solid at (x, y)?
+bool actor_collide_at(const MoveContext *context, const Actor *actor, int x, int y);
+// Return false if a solid stopped the actor before the end of the move
+bool actor_move_x(const MoveContext *context, Actor *actor, float amount);
+bool actor_move_y(const MoveContext *context, Actor *actor, float amount);
+// Whole-pixel moves that leave the remainder alone, for pushes and carries
+bool actor_move_x_exact(const MoveContext *context, Actor *actor, int move);
+bool actor_move_y_exact(const MoveContext *context, Actor *actor, int move);
+bool actor_is_riding(const Actor *actor, const Solid *solid); // standing on its top edge
+// Moves the solid, pushing and carrying the actors; those that cannot get out of the
+// way are flagged squished. solid must be one of context->solids or outside the context.
+void solid_move(const MoveContext *context, Solid *solid, float dx, float dy, Actor *const *actors, int actorCount);
+
+#endif // MOVEMENT_H
@@ -0,0 +1,74 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Frame breakdown: CPU zones timed with clock_gettime, GPU zones with GL_TIME_ELAPSED
+// queries. Each GPU zone has PROFILER_LATENCY query objects used round-robin, and a
+// frame's results are read PROFILER_LATENCY frames later, when they are long available,
+// so reading them never stalls the pipeline. Completed frames go to a rolling history
+// of PROFILER_HISTORY frames and, optionally, one CSV row each.
+// Every zone is timed at most once per frame; GPU zones must not nest.
+#define PROFILER_HISTORY 240
+#define PROFILER_LATENCY 4 // more than RENDERER_FRAMES_IN_FLIGHT
+
+typedef enum
+{
+    PROFILE_UPDATE,  // update()
+    PROFILE_RENDER,  // render(), gather and submit included
+    PROFILE_GATHER,  // renderer_set_sprites
+    PROFILE_SUBMIT,  // renderer_submit_sprites: sort + copy into the instance ring
+    PROFILE_PRESENT, // glfwSwapBuffers + glfwPollEvents
+    PROFILE_CPU_ZONE_COUNT
+} ProfileCpuZone;
+
+typedef enum
+{
+    PROFILE_GPU_SETUP,       // renderer_begin_frame: streamed texture uploads, clear
+    PROFILE_GPU_TILEMAP,
+    PROFILE_GPU_OPAQUE,      // renderer_draw_pass, GPU culling included
+    PROFILE_GPU_TRANSLUCENT,
+    PROFILE_GPU_BLIT,        // upscale to the window
+    PROFILE_GPU_ZONE_COUNT
+} ProfileGpuZone;
+
+typedef struct
+{
+    uint64_t frame;
+    double frameMs;                        // profiler_begin_frame to profiler_end_frame
+    double cpuMs[PROFILE_CPU_ZONE_COUNT];
+    double gpuMs[PROFILE_GPU_ZONE_COUNT];  // negative if the zone did not run
+} ProfileFrame;
+
+typedef struct
+{
+    bool enabled;
+    uint64_t frame;              // frame being recorded
+    double frameStart;
+    double cpuStart[PROFILE_CPU_ZONE_COUNT];
+    ProfileFrame current;
+    GLuint queries[PROFILER_LATENCY][PROFILE_GPU_ZONE_COUNT];
+    bool issued[PROFILER_LATENCY][PROFILE_GPU_ZONE_COUNT];
+    ProfileFrame pending[PROFILER_LATENCY]; // CPU times waiting for their GPU results
+    ProfileFrame history[PROFILER_HISTORY];
+    int historyCount;            // valid entries, the newest at (historyHead - 1)
+    int historyHead;
+    FILE *csv;
+} Profiler;
+
+// With the GL context current. csvPath may be NULL (history only).
+bool profiler_init(Profiler *profiler, const char *csvPath);
+void profiler_begin_frame(Profiler *profiler); // collects the GPU results of PROFILER_LATENCY frames ago
+void profiler_end_frame(Profiler *profiler);
+void profiler_cpu_begin(Profiler *profiler, ProfileCpuZone zone);
+void profiler_cpu_end(Profiler *profiler, ProfileCpuZone zone);
+// profiler may be NULL or disabled: nothing is recorded
+void profiler_gpu_begin(Profiler *profiler, ProfileGpuZone zone);
+void profiler_gpu_end(Profiler *profiler, ProfileGpuZone zone);
+void profiler_free(Profiler *profiler); // waits for the last GPU results and closes the CSV
+void profiler_print_summary(const Profiler *profiler); // mean and max of each zone over the history
+
+#endif // PROFILER_H
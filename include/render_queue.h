@@ -0,0 +1,67 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sprite.h"
+
+// Passes, drawn in this order
+typedef enum
+{
+    RENDER_PASS_OPAQUE,
+    RENDER_PASS_TRANSLUCENT,
+    RENDER_PASS_COUNT
+} RenderPass;
+
+// Sorting layers inside a pass (up to 64)
+typedef enum
+{
+    RENDER_LAYER_DECORATIONS,
+    RENDER_LAYER_ENTITIES,
+    RENDER_LAYER_COUNT
+} RenderLayer;
+
+// 64-bit sort key, most significant field first:
+//   63..62 pass | 61..56 layer | 55..24 zIndex | 23..16 variant | 15..0 texture layer
+// zIndex is stored as order-preserving float bits. The translucent pass goes back
+// to front (layers in order, then depth) for blending; the opaque pass reverses
+// both fields and goes front to back, so the depth test rejects hidden fragments
+// early. Instances sharing depth and texture end up adjacent.
+#define RENDER_KEY_PASS_SHIFT 62
+#define RENDER_KEY_LAYER_SHIFT 56
+#define RENDER_KEY_DEPTH_SHIFT 24
+#define RENDER_KEY_VARIANT_SHIFT 16
+
+uint64_t render_sort_key(const Sprite *sprite, RenderPass pass, RenderLayer layer);
+
+static inline SpriteVariant render_key_variant(uint64_t key)
+{
+    return (SpriteVariant)((key >> RENDER_KEY_VARIANT_SHIFT) & 0xFF);
+}
+
+static inline RenderPass render_key_pass(uint64_t key)
+{
+    return (RenderPass)(key >> RENDER_KEY_PASS_SHIFT);
+}
+
+// Keys with the item they order (an index into the caller's sprite array)
+typedef struct
+{
+    uint64_t *keys;
+    uint32_t *items;
+    uint64_t *scratchKeys; // ping-pong buffers of the radix sort
+    uint32_t *scratchItems;
+    size_t count;
+    size_t capacity;
+} RenderQueue;
+
+int render_queue_init(RenderQueue *queue, size_t capacity);
+void render_queue_free(RenderQueue *queue);
+void render_queue_clear(RenderQueue *queue);
+// Returns 0 when the queue is full
+int render_queue_push(RenderQueue *queue, uint64_t key, uint32_t item);
+// Stable LSD radix sort, 8 bits per pass; passes where every key has the same
+// byte are skipped, so the usual handful of distinct keys costs 2-3 passes
+void render_queue_sort(RenderQueue *queue);
+
+#endif // RENDER_QUEUE_H
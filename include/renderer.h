@@ -5,22 +5,164 @@
 #include <GLFW/glfw3.h>
 #include "sprite.h"     // Include the Sprite struct definition
 #include "entities.h"
+#include "cull.h"
+#include "render_queue.h"
+#include "tilemap.h"
+#include "atlas.h"
+#include "texture_loader.h"
+#include "texture_stream.h"
+#include "texture_residency.h"
+#include "shader_watch.h"
+#include "profiler.h"
 #include <linmath.h>
 
+// Number of instance ring regions; the CPU can run this many frames ahead of the GPU
+#define RENDERER_FRAMES_IN_FLIGHT 3
+
+// renderer_init flags
+#define RENDERER_PACKED_INSTANCES (1u << 0) // upload 32-byte PackedSprite instead of 64-byte Sprite
+#define RENDERER_VERTEX_PULLING   (1u << 1) // quad corners from gl_VertexID, no quad VBO
+#define RENDERER_SHADER_HOT_RELOAD (1u << 2) // rebuild the programs when a file in shaders/ changes
+
+// Internal render target: every pass draws at this resolution (one texel per world unit),
+// then renderer_end_frame blits it to the window at the largest integer scale that fits
+#define RENDERER_GAME_WIDTH 480
+#define RENDERER_GAME_HEIGHT 270
+
+// Instance batches drawn each frame; each one owns an indirect draw command
+typedef enum {
+    RENDERER_BATCH_STATIC,
+    RENDERER_BATCH_DYNAMIC,
+    RENDERER_BATCH_COUNT
+} RendererBatch;
+
+// Tilemap chunks drawn per instanced call (size of the chunkRects uniform array)
+#define RENDERER_TILEMAP_BATCH 64
+
+// Texture array layers tracked for pass selection
+#define RENDERER_MAX_TEXTURE_LAYERS TEXTURE_RESIDENCY_MAX_LAYERS
+#define RENDERER_STREAMED_LAYERS 4 // spare slots after the loaded layers, for renderer_stream_layer
+#define RENDERER_TEXTURE_BUDGET_MB 64 // VRAM for the texture array, mip chains included
+
+// A program being compiled and linked, possibly on the driver's threads
+// (KHR_parallel_shader_compile); shaderCount is 0 when it came from the shader cache
+typedef struct {
+    GLuint program;
+    GLuint shaders[2];
+    int shaderCount;
+    uint64_t key;          // shader cache key of the expanded sources
+    bool failed;           // a source could not be read
+} ShaderBuild;
+
+// Consecutive sorted instances drawn with one call (same pass and shader variant)
+typedef struct {
+    uint32_t first;        // relative to the start of the batch
+    uint32_t count;
+    RenderPass pass;
+    SpriteVariant variant;
+} RenderRun;
+
+// Where off-screen sprites are rejected
+typedef enum {
+    RENDERER_CULL_NONE, // draw everything
+    RENDERER_CULL_CPU,  // cull_sprites in the gather; decorations are streamed visible-only
+    RENDERER_CULL_GPU,  // sprite_cull.comp + glDrawArraysIndirect
+    RENDERER_CULL_MODE_COUNT
+} RendererCullMode;
+
 typedef struct {
-    GLuint quadVAO;
-    GLuint instanceSSBO;
-    GLuint shaderProgram;
+    GLuint quadVAO;        // quad VBO + attributes, or empty with RENDERER_VERTEX_PULLING
+    GLenum quadMode;       // GL_TRIANGLES (6 vertices) or GL_TRIANGLE_STRIP (4 vertices)
+    GLsizei quadVertexCount;
+    GLuint instanceSSBO;   // ring of RENDERER_FRAMES_IN_FLIGHT regions, maxSprites each
+    GLuint staticSSBO;     // decorations, MAX_STATIC_OBJECTS sprites, uploaded only when edited
+    size_t staticCount;
+    GLuint shaderPrograms[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT]; // sprite.vert/sprite.frag permutations
     mat4x4 projection;
     size_t maxSprites;
+    unsigned flags;        // RENDERER_* flags given to renderer_init
+    size_t instanceStride; // sizeof(Sprite) or sizeof(PackedSprite)
+    void *instanceRing;    // persistent, coherent mapping of instanceSSBO
+    GLsync frameFences[RENDERER_FRAMES_IN_FLIGHT];
+    size_t frameRegion;    // ring region written by the current frame
+    RendererCullMode cullMode;
+    GLuint cullProgram;        // shaders/sprite_cull.comp, 0 if compute culling is unavailable
+    GLuint visibleSSBO;        // compacted visible sprite indices, binding 1
+    GLuint drawCommandBuffer;  // one DrawArraysIndirectCommand per RenderRun, binding 2
+    vec2 viewSize;             // visible world rectangle (the game resolution)
+    GLuint sceneFBO;           // RENDERER_GAME_WIDTH x RENDERER_GAME_HEIGHT, color + depth renderbuffers
+    GLuint sceneColor, sceneDepth;
+    int screenWidth, screenHeight;
+    int sceneRect[4];          // window rectangle the scene is blitted to: x0, y0, x1, y1
+    GLuint windowFBO;          // framebuffer bound at renderer_init (0, or the offscreen one when headless)
+    char shaderDefines[256];   // #define block prepended to every shader (load_shader_source)
+    Sprite *staging;           // the gather writes here, draw copies it into the ring in key order
+    RenderQueue queue;         // sort keys of the staged sprites, filled by renderer_set_sprites
+    RenderRun *runs;           // runs of the sorted dynamic batch
+    size_t runCount;           // 0 until renderer_submit_sprites in the current frame
+    size_t runFirstSprite;     // ring index of the dynamic batch
+    void *staticMirror;        // CPU copy of staticSSBO (instanceStride per sprite)
+    uint32_t *staticSlot;      // decoration -> slot in staticSSBO
+    uint64_t *staticKey;       // decoration -> sort key it was placed with
+    RenderQueue staticQueue;
+    RenderRun *staticRuns;
+    size_t staticRunCount;
+    GLuint tileProgram;        // shaders/tilemap.vert + tilemap.frag
+    GLuint tileVAO;            // empty: chunk quads come from gl_VertexID
+    GLuint tileIndexTexture;   // GL_R16UI, one texel per tile of the synced TileMap
+    int tileIndexWidth, tileIndexHeight;
+    GLuint textureArray;       // sprite layers, from the packed atlas or assets/textures/N.png
+    int textureLayerCount;     // slots of the array: loaded layers + RENDERER_STREAMED_LAYERS, within the budget
+    TextureStream textureStream;  // loads into slots of the array
+    TextureResidency residency;   // layerIndex -> slot, LRU eviction
+    uint64_t staticLayers;     // layers referenced by the decorations
+    uint64_t tileLayers;       // tileset layer of the synced TileMap
+    uint64_t frameLayers;      // layers of the sprites gathered this frame
+    bool staticKeysStale;      // a layer changed translucency: the static keys must be rebuilt
+    TextureStreamCallback layerCallback[RENDERER_MAX_TEXTURE_LAYERS]; // renderer_stream_layer callbacks
+    void *layerCallbackUser[RENDERER_MAX_TEXTURE_LAYERS];
+    Atlas atlas;               // regions of assets/atlas, empty when the legacy textures are used
+    // Per layerIndex: set when it failed to load or, outside the atlas, has texels with alpha < 1.
+    // Atlas pages are classified per region (ATLAS_REGION_OPAQUE) in sprite_pass.
+    uint8_t layerTranslucent[RENDERER_MAX_TEXTURE_LAYERS];
+    ParallaxTable parallax;    // packed mode: parallax pairs referenced by PackedSprite.parallax
+    ShaderWatch shaderWatch;   // RENDERER_SHADER_HOT_RELOAD: inotify on shaders/
+    bool shadersReloading;     // the builds below are in flight
+    ShaderBuild spriteBuilds[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+    ShaderBuild tileBuild, cullBuild;
+    Profiler *profiler;        // times the GPU passes when set by the caller, NULL by default
 } Renderer;
 
 // Function declarations related to rendering
-int renderer_init(Renderer* renderer, size_t maxSprites, int screenWidth, int screenHeight);
-void renderer_begin_frame(Renderer* renderer); //Might be used to setup things needed at the beginning of each frame
-void renderer_draw_sprites(Renderer* renderer, Sprite* sprites, size_t numSprites);
-void renderer_end_frame(Renderer* renderer);   //Might be used to execute drawing commands
+// textures: loader started by the caller before creating the context, or NULL to decode here.
+// Frames end up in the framebuffer bound when it is called.
+int renderer_init(Renderer* renderer, size_t maxSprites, int screenWidth, int screenHeight, unsigned flags, TextureLoader* textures);
+void renderer_begin_frame(Renderer* renderer); // also completes streamed texture uploads
+// Loads path as layer (a layerIndex, it may be in use) in the background, into a slot of the
+// texture array; callback runs on this thread from renderer_begin_frame with the layer index.
+// False if it could not be queued. Non-resident layers referenced by a frame are loaded the same way.
+bool renderer_stream_layer(Renderer* renderer, int layer, const char* path, TextureStreamCallback callback, void* user);
+Sprite* renderer_frame_instances(Renderer* renderer); // where the current frame's gather writes (CPU staging)
+size_t renderer_frame_offset(Renderer* renderer);     // index of that region's first sprite in the ring
+// Sorts the staged sprites by key and copies them into the ring at firstSprite. Call it
+// after renderer_sync_static: it also resets the GPU culling commands of both batches.
+void renderer_submit_sprites(Renderer* renderer, size_t firstSprite, size_t numSprites);
+void renderer_sync_static(Renderer* renderer, GameWorld* world); // uploads the dirty decoration range
+// Draws the decorations and the submitted sprites of one pass. Call it for the opaque
+// pass (front to back, depth writes) before the translucent one (back to front, blended).
+void renderer_draw_pass(Renderer* renderer, RenderPass pass);
+// Uploads the dirty tiles (recreating the index texture when the map size changes)
+void renderer_sync_tilemap(Renderer* renderer, TileMap* map);
+// Draws the visible, non-empty chunks of the synced map: one instance per chunk.
+// Tiles are opaque, call it next to the opaque pass.
+void renderer_draw_tilemap(Renderer* renderer, const TileMap* map);
+void renderer_end_frame(Renderer* renderer);   // Blits the scene to the window and fences the current ring region
 void renderer_cleanup(Renderer* renderer);
-size_t renderer_set_sprites(GameWorld* world, Sprite* drawing);
+void renderer_cycle_cull_mode(Renderer* renderer);
+CullView renderer_cull_view(Renderer* renderer);
+// Gathers the dynamic entities. With CPU culling it also streams the visible decorations
+// (renderer_draw_pass then skips the static batch) and drops every sprite outside the view.
+// Each sprite gets its sort key in renderer->queue for renderer_submit_sprites.
+size_t renderer_set_sprites(Renderer* renderer, GameWorld* world, Sprite* drawing);
 
 #endif // RENDERER_H
\ No newline at end of file
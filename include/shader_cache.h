@@ -0,0 +1,33 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Linked program binaries (glGetProgramBinary) in SHADER_CACHE_DIR, one file per program:
+//   ShaderCacheHeader, then the driver's binary.
+// The key hashes the preprocessed sources of every stage; the header also records a hash
+// of GL_VENDOR / GL_RENDERER / GL_VERSION, so a driver update just recompiles.
+#define SHADER_CACHE_DIR "assets/cache"
+#define SHADER_CACHE_MAGIC 0x50524853u // "SHRP"
+#define SHADER_CACHE_VERSION 1
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t deviceHash;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+} ShaderCacheHeader; // Total: 32 bytes
+
+void shader_cache_init(void); // after the GL context exists; disables itself without binary formats
+uint64_t shader_cache_key(const char *const *sources, int count);
+// Program created from the cached binary, 0 if missing or rejected by the driver
+GLuint shader_cache_load(uint64_t key);
+void shader_cache_store(GLuint program, uint64_t key);
+void shader_cache_stats(int *loaded, int *compiled); // programs served by the cache / stored this run
+
+#endif // SHADER_CACHE_H
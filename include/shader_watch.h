@@ -0,0 +1,20 @@
+#ifndef SHADER_WATCH_H
+#define SHADER_WATCH_H
+
+#include <stdbool.h>
+
+// Watches a shader directory with inotify (non-blocking). Only files written or
+// moved in with a shader extension (.vert .frag .comp .glsl) count, so editor swap
+// and backup files do not trigger a reload.
+typedef struct
+{
+    int fd;     // inotify instance, -1 when the watch is off
+    int watch;
+} ShaderWatch;
+
+bool shader_watch_init(ShaderWatch *watch, const char *directory);
+// True if a shader changed since the last call; drains every pending event
+bool shader_watch_poll(ShaderWatch *watch);
+void shader_watch_free(ShaderWatch *watch);
+
+#endif // SHADER_WATCH_H
@@ -0,0 +1,34 @@
+#ifndef SOLID_GRID_H
+#define SOLID_GRID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tilemap.h"
+
+// Solid tiles of a room as packed bitsets, one bit per TILEMAP_TILE_SIZE tile and one
+// row of 64-bit words per tile row. A rectangle in pixels covers a run of bits in a few
+// rows: each row is answered with one masked AND per word (popcount for counts), so a
+// probe the size of an actor reads one or two words per row.
+// Outside the map nothing is solid.
+#define SOLID_GRID_TILE_PIXELS 8 // TILEMAP_TILE_SIZE as an integer
+
+typedef struct
+{
+    int width, height;    // in tiles
+    int wordsPerRow;
+    uint64_t *rows;       // height * wordsPerRow, bit x % 64 of word x / 64 is tile x
+} SolidGrid;
+
+bool solid_grid_init(SolidGrid *grid, int width, int height); // all empty
+void solid_grid_free(SolidGrid *grid);
+// Every non-empty tile of the map is solid; the grid takes the map's size
+bool solid_grid_build(SolidGrid *grid, const TileMap *map);
+// Re-reads the tiles [x0, x1) x [y0, y1) after the map was edited
+void solid_grid_update(SolidGrid *grid, const TileMap *map, int x0, int y0, int x1, int y1);
+void solid_grid_set(SolidGrid *grid, int x, int y, bool solid);
+bool solid_grid_get(const SolidGrid *grid, int x, int y);
+// Pixel rectangle [x, x + w) x [y, y + h): does it touch a solid tile, and how many
+bool solid_grid_collide_rect(const SolidGrid *grid, int x, int y, int w, int h);
+int solid_grid_count_rect(const SolidGrid *grid, int x, int y, int w, int h);
+
+#endif // SOLID_GRID_H
@@ -0,0 +1,40 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Uniform-grid broadphase over axis-aligned boxes, rebuilt every tick: the cells
+// are hashed into a power-of-two bucket table and a counting sort lays the entries
+// out bucket by bucket, so the build is O(n) and a query walks contiguous memory.
+// A box goes into every cell it touches; queries report each item at most once.
+// Candidates are only near the query box: the exact test is up to the caller
+// (check_collision), which also covers cells sharing a bucket.
+typedef struct
+{
+    float cellSize;       // world units, set per room
+    float invCellSize;
+    int *ids;             // per item, in insertion order: the caller's id
+    int *cellRanges;      // per item: x0, y0, x1, y1 inclusive cell range
+    uint32_t *stamps;     // per item: last query that reported it
+    int itemCount, itemCapacity;
+    int *bucketStart;     // bucketCount + 1 offsets into entries
+    int *entries;         // item indices grouped by bucket
+    int entryCount, entryCapacity;
+    uint32_t bucketMask;  // bucketCount - 1
+    int bucketCapacity;
+    uint32_t queryStamp;
+} SpatialGrid;
+
+void spatial_grid_init(SpatialGrid *grid, float cellSize);
+void spatial_grid_free(SpatialGrid *grid);
+// Starts a new build: drops every item; a different cellSize takes effect here
+void spatial_grid_clear(SpatialGrid *grid, float cellSize);
+bool spatial_grid_insert(SpatialGrid *grid, int id, float x, float y, float width, float height);
+bool spatial_grid_build(SpatialGrid *grid); // after the inserts, before the queries
+// Writes the ids of the items whose cells overlap the box into out (up to max) and
+// returns how many there are in total, possibly more than max
+int spatial_grid_query(SpatialGrid *grid, float x, float y, float width, float height, int *out, int max);
+
+#endif // SPATIAL_GRID_H
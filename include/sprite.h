@@ -2,6 +2,7 @@
 #define SPRITE_H
 
 #include <linmath.h>
+#include <stdint.h>
 
 typedef struct
 {
@@ -15,11 +16,56 @@ typedef struct
     float parallaxFactorX; // 4 bytes, offset 40 (ex padding2[0])
     float parallaxFactorY; // 4 bytes, offset 44 (ex padding2[1])
     vec3 color;        // 4 bytes, offset 48
-} Sprite;                  // Total: 52 bytes
+} Sprite;                  // Total: 64 bytes
+
+// Positions in a PackedSprite are half floats relative to the origin of a
+// SPRITE_CHUNK_SIZE x SPRITE_CHUNK_SIZE world chunk (precision 1/8 px at the far edge)
+#define SPRITE_CHUNK_SIZE 256.0f
+#define SPRITE_MAX_PARALLAX 16
+
+// Compact GPU instance layout (RENDERER_PACKED_INSTANCES), unpacked by fetch_sprite in
+// shaders/sprite_data.glsl. Sprite stays the authoring format.
+typedef struct
+{
+    uint16_t uvStart[2];   // unorm16, offset 0
+    uint16_t uvEnd[2];     // unorm16, offset 4
+    uint16_t position[2];  // half, offset 8 (relative to the chunk origin)
+    uint16_t size[2];      // half, offset 12
+    int16_t chunk[2];      // offset 16, chunk origin = chunk * SPRITE_CHUNK_SIZE
+    uint16_t rotation;     // half, offset 20 (wrapped to [0, 2pi))
+    uint16_t zIndex;       // half, offset 22
+    uint8_t layer;         // offset 24
+    uint8_t parallax;      // offset 25, index into a ParallaxTable
+    uint16_t flags;        // offset 26, reserved
+    uint32_t color;        // RGBA8, offset 28
+} PackedSprite;            // Total: 32 bytes
+
+// Distinct (parallaxFactorX, parallaxFactorY) pairs referenced by packed sprites
+typedef struct
+{
+    vec2 factors[SPRITE_MAX_PARALLAX];
+    int count;
+    int dirty; // set when a pair is added, cleared by whoever uploads the table
+} ParallaxTable;
+
+// Vertex shader permutations compiled at renderer_init (VARIANT_* defines in
+// shaders/sprite.vert). The renderer buckets instances so each draw runs the
+// cheapest math the sprites in it need.
+typedef enum
+{
+    SPRITE_VARIANT_NO_PARALLAX,  // rotation == 0 and parallax (1, 1)
+    SPRITE_VARIANT_AXIS_ALIGNED, // rotation == 0
+    SPRITE_VARIANT_ROTATED,      // 2x2 rotation around Z
+    SPRITE_VARIANT_COUNT
+} SpriteVariant;
 
 // Function declarations related to Sprite *data* manipulation
 void sprite_init(Sprite *sprite, float x, float y, float width, float height, vec2 uvStart, vec2 uvEnd, float layerIndex, float parX, float parY, float zIndex);
 void sprite_update(Sprite *sprite, float deltaTime); // Example: Update position, rotation, etc.
+void sprite_pack(const Sprite *sprite, ParallaxTable *parallax, PackedSprite *packed);
+uint8_t parallax_table_index(ParallaxTable *table, float parX, float parY);
+uint16_t float_to_half(float value);
+SpriteVariant sprite_variant(const Sprite *sprite);
 // ... other Sprite-specific functions ...
 
 #endif // SPRITE_H
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef SWEEP_PRUNE_H
+#define SWEEP_PRUNE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sort-and-sweep broadphase with persistent proxies. The x endpoints of every box
+// stay sorted across updates and are re-sorted by insertion, which is close to O(n)
+// when boxes move a little between frames; the sweep over them tests y and the
+// category masks. Touching boxes do not overlap, like check_collision.
+// Each update reports the overlapping pairs as BEGIN or PERSIST and the pairs that
+// stopped overlapping (or lost a proxy) as END, all sorted by (a, b).
+typedef enum
+{
+    SWEEP_PAIR_BEGIN,
+    SWEEP_PAIR_PERSIST,
+    SWEEP_PAIR_END,
+} SweepPairState;
+
+typedef struct
+{
+    int a, b;             // proxies, a < b
+    SweepPairState state;
+} SweepPair;
+
+typedef struct
+{
+    float minX, minY, maxX, maxY;
+    uint32_t category;    // pairs need (a.category & b.mask) || (b.category & a.mask)
+    uint32_t mask;
+    int user;             // caller data, e.g. the index of the entity
+    int activeSlot;       // position in the sweep's active list
+    bool alive;
+} SweepProxy;
+
+typedef struct
+{
+    float value;
+    uint32_t data;        // proxy << 1, | 1 for a max endpoint: at equal value min sorts first, so touching boxes pair
+} SweepEndpoint;
+
+typedef struct
+{
+    SweepProxy *proxies;
+    int proxyCount, proxyCapacity;         // handles in use or free, [0, proxyCount)
+    int *freeProxies;                      // handles reusable now
+    int freeCount, freeCapacity;
+    int *removedProxies;                   // handles freed at the next update, after their END pairs
+    int removedCount, removedCapacity;
+    SweepEndpoint *endpoints;              // sorted on x, two per live proxy
+    int endpointCount, endpointCapacity;
+    int addedSinceUpdate;                  // unsorted endpoints appended at the end
+    void *active;                          // sweep scratch: proxies whose x interval is open
+    int activeCapacity;
+    uint64_t *current;                     // sweep scratch: a << 32 | b of this update
+    int currentCount, currentCapacity;
+    uint64_t *previous;                    // the overlapping pairs of the last update
+    int previousCount, previousCapacity;
+    SweepPair *pairs;                      // events of the last update
+    int pairCount, pairCapacity;
+} SweepPrune;
+
+void sweep_prune_init(SweepPrune *sap);
+void sweep_prune_free(SweepPrune *sap);
+// Returns the proxy handle, -1 if out of memory. The box is [x, x + width) x [y, y + height)
+int sweep_prune_add(SweepPrune *sap, float x, float y, float width, float height, uint32_t category, uint32_t mask,
+                    int user);
+void sweep_prune_remove(SweepPrune *sap, int proxy); // its pairs end at the next update
+void sweep_prune_move(SweepPrune *sap, int proxy, float x, float y, float width, float height, int user);
+// Re-sorts the endpoints, sweeps and fills the pair events
+bool sweep_prune_update(SweepPrune *sap);
+const SweepPair *sweep_prune_pairs(const SweepPrune *sap, int *count);
+static inline const SweepProxy *sweep_prune_proxy(const SweepPrune *sap, int proxy)
+{
+    return &sap->proxies[proxy];
+}
+
+#endif // SWEEP_PRUNE_H
@@ -0,0 +1,45 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pre-decoded texture layers, one file per source PNG in TEXTURE_CACHE_DIR:
+//   TextureCacheHeader, then the RGBA8 mip chain (level 0 first, tightly packed).
+// An entry is valid while the source keeps its size and mtime, or its content hash
+// when only the mtime changed (e.g. after a git checkout).
+#define TEXTURE_CACHE_DIR "assets/cache"
+#define TEXTURE_CACHE_MAGIC 0x43584554u // "TEXC"
+#define TEXTURE_CACHE_VERSION 2 // 2: mip levels filtered with premultiplied alpha
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;  // FNV-1a 64 of the PNG bytes
+    int64_t sourceMtime;  // nanoseconds
+    uint64_t sourceSize;
+    uint32_t width, height;
+    uint32_t mipLevels;
+    uint32_t translucent; // some texel has alpha < 255
+} TextureCacheHeader;     // Total: 48 bytes
+
+typedef struct
+{
+    TextureCacheHeader header;
+    const unsigned char *pixels; // mip chain inside the mapping
+    void *mapping;
+    size_t mappingSize;
+} TextureCacheEntry;
+
+uint64_t texture_cache_hash(const void *data, size_t size);
+size_t texture_cache_chain_size(int width, int height, int mipLevels); // bytes of an RGBA8 mip chain
+// Maps the entry for sourcePath if it is still valid for the file on disk
+bool texture_cache_open(const char *sourcePath, TextureCacheEntry *entry);
+void texture_cache_close(TextureCacheEntry *entry);
+// Writes (atomically, through a rename) the entry for a source whose bytes hash to sourceHash
+bool texture_cache_write(const char *sourcePath, uint64_t sourceHash, const TextureCacheHeader *layout,
+                         const unsigned char *pixels);
+
+#endif // TEXTURE_CACHE_H
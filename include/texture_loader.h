@@ -0,0 +1,61 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "atlas.h"
+#include "clock_ms.h"
+#include "texture_cache.h"
+
+// Decodes the texture array layers on worker threads while the main thread creates
+// the window and the GL context. Only the glTexSubImage3D uploads (renderer_init)
+// need the GL thread. Layers found in the texture cache are mmapped instead of decoded.
+#define TEXTURE_LOADER_MAX_THREADS 8
+#define TEXTURE_LOADER_MAX_LAYERS 64 // same as RENDERER_MAX_TEXTURE_LAYERS
+
+typedef struct
+{
+    char path[256];
+    int mipLimit;          // input: at most this many mip levels, 0 for the full chain
+    const unsigned char *pixels; // RGBA8 mip chain, level 0 first; NULL if the load failed
+    int width, height;
+    int mipLevels;
+    bool translucent;      // some texel has alpha < 255 (or the layer failed to load)
+    TextureCacheEntry cache; // mapping pixels points into, when the layer came from the cache
+} TextureLayer;
+
+typedef struct
+{
+    Atlas atlas;           // manifest of assets/atlas, empty for the legacy textures
+    bool useAtlas;
+    int width, height;     // size of every layer of the array
+    int mipLevels;         // of every layer: the full chain, capped for atlas pages
+    int layerCount;
+    TextureLayer layers[TEXTURE_LOADER_MAX_LAYERS];
+    pthread_t threads[TEXTURE_LOADER_MAX_THREADS];
+    int threadCount;
+    atomic_int nextLayer;  // next layer a worker picks up
+    atomic_int pending;    // layers not decoded yet
+    atomic_int cacheHits;  // layers mapped from the texture cache
+    // tempi in millisecondi, per il riepilogo dell'avvio
+    double startTime;
+    double decodeWallMs;   // from texture_loader_start to the last decoded layer
+    atomic_llong decodeCpuNs; // CLOCK_THREAD_CPUTIME_ID spent loading layers, summed over the workers
+    double waitMs;         // main thread blocked in texture_loader_wait
+    double uploadMs;       // glTexSubImage3D calls, filled in by the renderer
+} TextureLoader;
+
+int texture_loader_mip_levels(int width, int height); // full chain down to 1x1
+// Loads layer->path from the texture cache or decodes it (and refreshes the cache), on any thread
+bool texture_layer_load(TextureLayer *layer);
+void texture_layer_free(TextureLayer *layer);
+// Picks the layer list (packed atlas or assets/textures/N.png) and starts decoding.
+// threads <= 0 uses one thread per online CPU.
+void texture_loader_start(TextureLoader *loader, int threads);
+void texture_loader_wait(TextureLoader *loader);
+// Joins the workers, then frees the pixel data and anything the renderer did not take.
+// Also the way out when startup fails before renderer_init consumed the loader.
+void texture_loader_free(TextureLoader *loader);
+
+#endif // TEXTURE_LOADER_H
@@ -0,0 +1,41 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Which texture layers live in the texture array. Sprites reference a layer by
+// layerIndex (up to TEXTURE_RESIDENCY_MAX_LAYERS of them); the array only has
+// slotCount slots, sized by the VRAM budget. A layer referenced by a frame that is not
+// resident gets a slot, free or least recently used among the unreferenced ones.
+// The sprite shaders translate layerIndex through the layer -> slot map (layerMap).
+#define TEXTURE_RESIDENCY_MAX_LAYERS 64 // one bit each in a uint64_t reference mask
+#define TEXTURE_RESIDENCY_NONE -1
+
+typedef struct
+{
+    int layerCount; // layers with a source path
+    int slotCount;  // slots in the texture array
+    char paths[TEXTURE_RESIDENCY_MAX_LAYERS][256];
+    int32_t slotOf[TEXTURE_RESIDENCY_MAX_LAYERS];  // layer -> slot, NONE until its upload completes
+    int32_t layerOf[TEXTURE_RESIDENCY_MAX_LAYERS]; // slot -> layer (also while loading), NONE if free
+    uint64_t lastUsed[TEXTURE_RESIDENCY_MAX_LAYERS]; // per slot, frame of the last reference
+    uint64_t loading;  // layers being streamed
+    uint64_t failed;   // layers whose source could not be loaded, not retried
+    uint64_t frame;
+    bool changed;      // slotOf changed; the renderer clears it after uploading layerMap
+} TextureResidency;
+
+void texture_residency_init(TextureResidency *residency, int slotCount);
+// Sets the source of a layer; a resident copy stays until it is reloaded
+void texture_residency_set_path(TextureResidency *residency, int layer, const char *path);
+// Marks the layers in referenced as used by this frame and advances the frame counter
+void texture_residency_touch(TextureResidency *residency, uint64_t referenced);
+// Slot to load layer into: its own if resident, else a free one, else the LRU slot whose layer
+// is not in referenced (nor loading), which stops being resident. NONE if every slot is in use.
+int texture_residency_acquire(TextureResidency *residency, int layer, uint64_t referenced);
+void texture_residency_loaded(TextureResidency *residency, int slot, bool ok); // upload completed or failed
+void texture_residency_cancel(TextureResidency *residency, int slot); // the load could not be queued
+bool texture_residency_missing(const TextureResidency *residency, int layer); // referenced but must be loaded
+
+#endif // TEXTURE_RESIDENCY_H
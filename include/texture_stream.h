@@ -0,0 +1,69 @@
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+#include <glad/glad.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Loads texture array layers while the game runs. Worker threads decode (or map from
+// the texture cache) into persistently mapped GL_PIXEL_UNPACK_BUFFERs; the GL thread,
+// in texture_stream_update, only issues the glTexSubImage3D from the buffer and
+// fences it. A staging slot is reused once its fence has signaled.
+#define TEXTURE_STREAM_SLOTS 3
+#define TEXTURE_STREAM_THREADS 2
+#define TEXTURE_STREAM_MAX_REQUESTS 32
+
+// Called on the GL thread once the upload has completed (ok) or the layer failed to load
+typedef void (*TextureStreamCallback)(void *user, int layer, bool ok, bool translucent);
+
+typedef struct
+{
+    char path[256];
+    int layer;
+    TextureStreamCallback callback;
+    void *user;
+} TextureStreamRequest;
+
+typedef enum
+{
+    TEXTURE_SLOT_FREE,
+    TEXTURE_SLOT_DECODING,  // owned by a worker
+    TEXTURE_SLOT_READY,     // decoded, waiting for texture_stream_update
+    TEXTURE_SLOT_UPLOADING, // glTexSubImage3D issued, fence pending
+} TextureSlotState;
+
+typedef struct
+{
+    TextureSlotState state;
+    GLuint buffer;          // GL_PIXEL_UNPACK_BUFFER, chainSize bytes
+    unsigned char *mapped;  // persistent, coherent mapping of buffer
+    GLsync fence;
+    TextureStreamRequest request;
+    bool ok, translucent;
+} TextureStreamSlot;
+
+typedef struct
+{
+    GLuint textureArray;
+    int width, height, mipLevels, layerCount;
+    size_t chainSize;         // bytes of one layer with its mip chain
+    TextureStreamSlot slots[TEXTURE_STREAM_SLOTS];
+    TextureStreamRequest queue[TEXTURE_STREAM_MAX_REQUESTS];
+    int queueHead, queueCount;
+    pthread_t threads[TEXTURE_STREAM_THREADS];
+    int threadCount;
+    pthread_mutex_t mutex;    // slot states and queue
+    pthread_cond_t wake;      // a request was queued, a slot was freed, or quit
+    bool quit;
+} TextureStream;
+
+bool texture_stream_init(TextureStream *stream, GLuint textureArray, int width, int height, int mipLevels,
+                         int layerCount);
+// Queues path for layer; false if the layer is out of range or the queue is full
+bool texture_stream_request(TextureStream *stream, int layer, const char *path, TextureStreamCallback callback, void *user);
+void texture_stream_update(TextureStream *stream); // GL thread, once per frame
+bool texture_stream_idle(TextureStream *stream);   // nothing queued, decoding or uploading
+void texture_stream_free(TextureStream *stream);
+
+#endif // TEXTURE_STREAM_H
@@ -0,0 +1,35 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Level geometry of a room as a grid of tile indices. The renderer draws it one
+// chunk of TILEMAP_CHUNK_TILES x TILEMAP_CHUNK_TILES tiles per instance: the quad
+// looks its tiles up in a tile-index texture (shaders/tilemap.frag).
+#define TILEMAP_TILE_SIZE 8.0f   // world units per tile
+#define TILEMAP_CHUNK_TILES 32   // 256 x 256 world units per chunk
+#define TILEMAP_EMPTY 0          // tile index 0 draws nothing; n > 0 is atlas cell n - 1
+
+typedef struct
+{
+    int width, height;       // in tiles
+    int chunksX, chunksY;
+    uint16_t *tiles;         // width * height, row-major
+    uint16_t *chunkTiles;    // non-empty tiles per chunk, empty chunks are skipped
+    int tilesetLayer;        // texture array layer holding the tileset
+    int tilesetColumns;      // tiles per row (and per column) of the tileset layer
+    float zIndex;
+    // rettangolo [dirtyX0, dirtyX1) x [dirtyY0, dirtyY1) modificato dall'ultimo upload
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1;
+} TileMap;
+
+bool tilemap_init(TileMap *map, int width, int height, int tilesetLayer, int tilesetColumns, float zIndex);
+void tilemap_free(TileMap *map);
+void tilemap_set(TileMap *map, int x, int y, uint16_t tile);
+uint16_t tilemap_get(const TileMap *map, int x, int y); // TILEMAP_EMPTY outside the map
+void tilemap_fill(TileMap *map, int x0, int y0, int x1, int y1, uint16_t tile); // [x0, x1) x [y0, y1)
+bool tilemap_chunk_empty(const TileMap *map, int chunkX, int chunkY);
+
+#endif // TILEMAP_H
@@ -1,82 +1,77 @@
 #version 430 core
 
+#ifndef VERTEX_PULLING
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec2 aTexCoord;
+#endif
 
-// Define the sprite data structure
-struct SpriteData {
-    vec2 uvStart;
-    vec2 uvEnd;
-    float layerIndex;
-    float zIndex;
-    vec2 position;
-    vec2 size;
-    float rotation;
-    float parallaxFactorX;
-    float parallaxFactorY;
-    vec3 color;
-};
+#include "sprite_data.glsl"
 
-layout (std430, binding = 0) buffer SpriteBuffer {
-    SpriteData sprites[];
+// Indici sopravvissuti al culling (sprite_cull.comp)
+layout (std430, binding = 1) readonly buffer VisibleBuffer {
+    uint visible[];
 };
 
 uniform mat4 projection;
 uniform vec2 cameraPos;  // Solo questa uniform per la camera
+uniform int instanceOffset; // primo sprite della regione del ring usata da questo frame
+uniform bool useVisibleList; // draw indiretto dopo il culling su GPU
+uniform int visibleBase;     // primo slot del batch in VisibleBuffer
+uniform int layerMap[TEXTURE_LAYERS]; // layerIndex -> slot della texture array, -1 se non residente
 
 out vec2 texCoord;
-out flat int spriteID;
-
-// Define the matrix transformation functions
-mat4 translate(mat4 m, vec3 v) {
-    mat4 result = m;
-    result[3] = m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3];
-    return result;
-}
+out flat float layerIndex;
+out flat vec3 tint;
 
-mat4 rotate(mat4 m, float angle, vec3 axis) {
-    float c = cos(angle);
-    float s = sin(angle);
-    float t = 1.0 - c;
-    
-    axis = normalize(axis);
-    
-    mat4 rot = mat4(
-        t * axis.x * axis.x + c,           t * axis.x * axis.y - s * axis.z,  t * axis.x * axis.z + s * axis.y,  0.0,
-        t * axis.x * axis.y + s * axis.z,  t * axis.y * axis.y + c,           t * axis.y * axis.z - s * axis.x,  0.0,
-        t * axis.x * axis.z - s * axis.y,  t * axis.y * axis.z + s * axis.x,  t * axis.z * axis.z + c,           0.0,
-        0.0,                               0.0,                               0.0,                               1.0
-    );
-    
-    return m * rot;
-}
+void main() {
+#ifdef VERTEX_PULLING
+    // Triangle strip da 4 vertici senza VBO: (0,0) (1,0) (0,1) (1,1)
+    vec2 aTexCoord = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 aPos = aTexCoord - 0.5;
+#endif
+    int spriteID;
+    if (useVisibleList)
+        spriteID = int(visible[visibleBase + gl_InstanceID]);
+    else
+        spriteID = instanceOffset + gl_InstanceID;
+    SpriteData sprite = fetch_sprite(spriteID);
 
-mat4 scale(mat4 m, vec3 v) {
-    mat4 result = mat4(1.0);
-    result[0][0] = v.x;
-    result[1][1] = v.y;
-    result[2][2] = v.z;
-    return m * result;
-}
+    // Layer non (ancora) caricato: il quad finisce fuori dal clip space e non si disegna
+    int slot = layerMap[clamp(int(sprite.layerIndex), 0, TEXTURE_LAYERS - 1)];
+    if (slot < 0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
 
-void main() {
-    spriteID = gl_InstanceID;
-    
+    // Varianti compilate a renderer_init (vedi SpriteVariant in sprite.h):
+    // la matematica generica con tre mat4 si paga solo dove serve davvero
+#ifdef VARIANT_NO_PARALLAX
+    vec2 center = sprite.position - cameraPos;
+#else
     /// Calcola la posizione con parallasse separato per X e Y
-    vec2 parallaxPosition = sprites[gl_InstanceID].position - vec2(
-        cameraPos.x * sprites[gl_InstanceID].parallaxFactorX,
-        cameraPos.y * sprites[gl_InstanceID].parallaxFactorY
+    vec2 center = sprite.position - vec2(
+        cameraPos.x * sprite.parallaxFactorX,
+        cameraPos.y * sprite.parallaxFactorY
     );
-    
-    // Calcola la model matrix
-    mat4 model = mat4(1.0);
-    model = translate(model, vec3(parallaxPosition, 0.0));
-    model = rotate(model, sprites[gl_InstanceID].rotation, vec3(0.0, 0.0, 1.0));
-    model = scale(model, vec3(sprites[gl_InstanceID].size, 1.0));
+#endif
+
+    // L'angolo in alto a sinistra cade su un pixel intero del target a risoluzione di gioco:
+    // con la parallasse la posizione resta frazionaria anche se la camera è arrotondata
+    center = floor(center - 0.5 * sprite.size + 0.5) + 0.5 * sprite.size;
+
+    vec2 corner = aPos * sprite.size;
+#ifdef VARIANT_ROTATED
+    // Rotazione attorno a Z con una mat2 (stesso verso della vecchia rotate() su mat4)
+    float c = cos(sprite.rotation);
+    float s = sin(sprite.rotation);
+    corner = mat2(c, -s, s, c) * corner;
+#endif
 
      // Usa zIndex per la profondità
-    vec4 pos = projection * model * vec4(aPos, sprites[gl_InstanceID].zIndex, 1.0);
-    gl_Position = pos;
+    gl_Position = projection * vec4(center + corner, sprite.zIndex, 1.0);
     
-    texCoord = aTexCoord;
+    // Interpolate between uvStart and uvEnd (lineare, quindi equivalente a farlo nel fragment)
+    texCoord = mix(sprite.uvStart, sprite.uvEnd, aTexCoord);
+    layerIndex = float(slot);
+    tint = vec3(sprite.color[0], sprite.color[1], sprite.color[2]);
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+// Incluso da sprite.vert e sprite_cull.comp (vedi load_shader_source in renderer.c).
+// SPRITE_CHUNK_SIZE e PACKED_INSTANCES arrivano dal renderer come #define.
+
+// Define the sprite data structure
+struct SpriteData {
+    vec2 uvStart;
+    vec2 uvEnd;
+    float layerIndex;
+    float zIndex;
+    vec2 position;
+    vec2 size;
+    float rotation;
+    float parallaxFactorX;
+    float parallaxFactorY;
+    float color[3]; // float[3] e non vec3: in std430 un vec3 e' allineato a 16 byte e non corrisponderebbe al layout C
+};
+
+#ifdef PACKED_INSTANCES
+
+// PackedSprite (sprite.h), 32 byte
+struct PackedSpriteData {
+    uvec4 a; // uvStart unorm16x2, uvEnd unorm16x2, position half2, size half2
+    uvec4 b; // chunk int16x2, rotation|zIndex half2, layer|parallax|flags, color RGBA8
+};
+
+layout (std430, binding = 0) readonly buffer SpriteBuffer {
+    PackedSpriteData sprites[];
+};
+
+uniform vec2 parallaxTable[SPRITE_MAX_PARALLAX];
+
+SpriteData fetch_sprite(int id) {
+    PackedSpriteData p = sprites[id];
+    SpriteData sprite;
+
+    sprite.uvStart = unpackUnorm2x16(p.a.x);
+    sprite.uvEnd = unpackUnorm2x16(p.a.y);
+
+    ivec2 chunk = ivec2(bitfieldExtract(int(p.b.x), 0, 16), bitfieldExtract(int(p.b.x), 16, 16));
+    sprite.position = vec2(chunk) * SPRITE_CHUNK_SIZE + unpackHalf2x16(p.a.z);
+    sprite.size = unpackHalf2x16(p.a.w);
+
+    vec2 rotationZ = unpackHalf2x16(p.b.y);
+    sprite.rotation = rotationZ.x;
+    sprite.zIndex = rotationZ.y;
+
+    sprite.layerIndex = float(bitfieldExtract(p.b.z, 0, 8));
+    vec2 parallax = parallaxTable[bitfieldExtract(p.b.z, 8, 8)];
+    sprite.parallaxFactorX = parallax.x;
+    sprite.parallaxFactorY = parallax.y;
+
+    vec4 color = unpackUnorm4x8(p.b.w);
+    sprite.color[0] = color.r;
+    sprite.color[1] = color.g;
+    sprite.color[2] = color.b;
+    return sprite;
+}
+
+#else
+
+layout (std430, binding = 0) readonly buffer SpriteBuffer {
+    SpriteData sprites[];
+};
+
+SpriteData fetch_sprite(int id) {
+    return sprites[id];
+}
+
+#endif
@@ -0,0 +1,34 @@
+#version 430 core
+
+in vec2 tileCoord;
+
+out vec4 FragColor;
+
+uniform sampler2DArray textureArray; // unità 0, condivisa con gli sprite
+uniform usampler2D tileIndices;      // unità 1, un texel per tile
+uniform int tilesetLayer;
+uniform int tilesetColumns;
+
+void main() {
+    uint tile = texelFetch(tileIndices, ivec2(floor(tileCoord)), 0).r;
+    if (tile == 0u) // TILEMAP_EMPTY
+        discard;
+
+    uint index = tile - 1u;
+    uint columns = uint(tilesetColumns);
+    vec2 cell = vec2(index % columns, index / columns);
+
+    // Mezzo texel di margine per non filtrare dentro la cella accanto
+    float texelsPerTile = float(textureSize(textureArray, 0).x) / float(tilesetColumns);
+    vec2 inTile = clamp(fract(tileCoord), vec2(0.5 / texelsPerTile), vec2(1.0 - 0.5 / texelsPerTile));
+    vec2 uv = (cell + inTile) / float(tilesetColumns);
+
+    // fract() salta al bordo di ogni tile: le derivate si prendono da tileCoord, che è continuo
+    vec2 gradX = dFdx(tileCoord) / float(tilesetColumns);
+    vec2 gradY = dFdy(tileCoord) / float(tilesetColumns);
+    vec4 texColor = textureGrad(textureArray, vec3(uv, float(tilesetLayer)), gradX, gradY);
+    if (texColor.a < 0.5)
+        discard;
+
+    FragColor = vec4(texColor.rgb, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 430 core
+
+// Un'istanza per chunk: il quad copre il rettangolo di tile chunkRects[gl_InstanceID]
+// e gli angoli vengono da gl_VertexID (triangle strip da 4 vertici, nessun VBO)
+uniform ivec4 chunkRects[TILEMAP_DRAW_BATCH]; // x, y, larghezza, altezza in tile
+uniform mat4 projection;
+uniform vec2 cameraPos;
+uniform float tileSize;
+uniform float zIndex;
+
+out vec2 tileCoord;
+
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    ivec4 rect = chunkRects[gl_InstanceID];
+    tileCoord = vec2(rect.xy) + corner * vec2(rect.zw);
+    // Livello senza parallasse, come SPRITE_VARIANT_NO_PARALLAX
+    gl_Position = projection * vec4(tileCoord * tileSize - cameraPos, zIndex, 1.0);
+}
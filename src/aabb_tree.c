@@ -0,0 +1,426 @@
+#include "aabb_tree.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Il box grasso si allunga nella direzione del moto di questi spostamenti
+#define AABB_TREE_DISPLACEMENT_MULTIPLIER 4.0f
+
+static Aabb make_box(float x, float y, float width, float height)
+{
+    return (Aabb){x, y, x + width, y + height};
+}
+
+static Aabb box_union(Aabb a, Aabb b)
+{
+    return (Aabb){fminf(a.minX, b.minX), fminf(a.minY, b.minY), fmaxf(a.maxX, b.maxX), fmaxf(a.maxY, b.maxY)};
+}
+
+// In 2D l'euristica della superficie usa il perimetro
+static float box_perimeter(Aabb a)
+{
+    return 2.0f * ((a.maxX - a.minX) + (a.maxY - a.minY));
+}
+
+static bool box_contains(Aabb outer, Aabb inner)
+{
+    return outer.minX <= inner.minX && outer.minY <= inner.minY && inner.maxX <= outer.maxX &&
+           inner.maxY <= outer.maxY;
+}
+
+static bool box_overlap(Aabb a, Aabb b)
+{
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+static bool is_leaf(const AabbNode *node)
+{
+    return node->child1 == AABB_TREE_NULL;
+}
+
+// Raddoppia il pool; i nodi nuovi finiscono nella lista libera, concatenati tramite parent
+static bool grow_nodes(AabbTree *tree)
+{
+    int capacity = tree->nodeCapacity ? tree->nodeCapacity * 2 : 64;
+    AabbNode *nodes = realloc(tree->nodes, (size_t)capacity * sizeof(AabbNode));
+    if (!nodes)
+    {
+        perror("Memory allocation failed");
+        return false;
+    }
+    for (int i = tree->nodeCapacity; i < capacity; i++)
+    {
+        nodes[i].parent = i + 1 < capacity ? i + 1 : tree->freeList;
+        nodes[i].height = -1;
+    }
+    tree->nodes = nodes;
+    tree->freeList = tree->nodeCapacity;
+    tree->nodeCapacity = capacity;
+    return true;
+}
+
+// Chi chiama si è assicurato che ci sia un nodo libero
+static int allocate_node(AabbTree *tree)
+{
+    int index = tree->freeList;
+    AabbNode *node = &tree->nodes[index];
+    tree->freeList = node->parent;
+    node->parent = AABB_TREE_NULL;
+    node->child1 = AABB_TREE_NULL;
+    node->child2 = AABB_TREE_NULL;
+    node->height = 0;
+    node->category = 0;
+    node->user = -1;
+    tree->nodeCount++;
+    return index;
+}
+
+static void free_node(AabbTree *tree, int index)
+{
+    tree->nodes[index].parent = tree->freeList;
+    tree->nodes[index].height = -1;
+    tree->freeList = index;
+    tree->nodeCount--;
+}
+
+static void refit(AabbTree *tree, int index)
+{
+    AabbNode *node = &tree->nodes[index];
+    const AabbNode *child1 = &tree->nodes[node->child1];
+    const AabbNode *child2 = &tree->nodes[node->child2];
+    node->box = box_union(child1->box, child2->box);
+    node->category = child1->category | child2->category;
+    node->height = 1 + (child1->height > child2->height ? child1->height : child2->height);
+}
+
+static void replace_child(AabbTree *tree, int parent, int oldChild, int newChild)
+{
+    if (parent == AABB_TREE_NULL)
+        tree->root = newChild;
+    else if (tree->nodes[parent].child1 == oldChild)
+        tree->nodes[parent].child1 = newChild;
+    else
+        tree->nodes[parent].child2 = newChild;
+}
+
+// Se i due sottoalberi di a differiscono di più di un livello, il figlio più alto sale al
+// posto di a e a prende il nipote più basso. Restituisce la nuova radice del sottoalbero.
+static int balance(AabbTree *tree, int a)
+{
+    AabbNode *nodes = tree->nodes;
+    if (is_leaf(&nodes[a]) || nodes[a].height < 2)
+        return a;
+
+    int b = nodes[a].child1, c = nodes[a].child2;
+    int diff = nodes[c].height - nodes[b].height;
+    if (diff >= -1 && diff <= 1)
+        return a;
+
+    // up è il figlio che sale
+    int up = diff > 1 ? c : b;
+    int f = nodes[up].child1, g = nodes[up].child2;
+
+    nodes[up].child1 = a;
+    nodes[up].parent = nodes[a].parent;
+    nodes[a].parent = up;
+    replace_child(tree, nodes[up].parent, a, up);
+
+    // Il nipote più alto resta a up, l'altro passa ad a al posto di up
+    int keep = nodes[f].height > nodes[g].height ? f : g;
+    int move = keep == f ? g : f;
+    nodes[up].child2 = keep;
+    if (diff > 1)
+        nodes[a].child2 = move;
+    else
+        nodes[a].child1 = move;
+    nodes[move].parent = a;
+
+    refit(tree, a);
+    refit(tree, up);
+    return up;
+}
+
+static void insert_leaf(AabbTree *tree, int leaf)
+{
+    AabbNode *nodes = tree->nodes;
+    if (tree->root == AABB_TREE_NULL)
+    {
+        tree->root = leaf;
+        nodes[leaf].parent = AABB_TREE_NULL;
+        return;
+    }
+
+    // Scende verso il fratello più economico: fermarsi qui costa 2 * perimetro dell'unione,
+    // scendere in un figlio costa la crescita di quel figlio più quella ereditata dagli antenati
+    Aabb leafBox = nodes[leaf].box;
+    int index = tree->root;
+    while (!is_leaf(&nodes[index]))
+    {
+        int child1 = nodes[index].child1, child2 = nodes[index].child2;
+        float area = box_perimeter(nodes[index].box);
+        float combinedArea = box_perimeter(box_union(nodes[index].box, leafBox));
+        float cost = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - area);
+
+        float cost1 = box_perimeter(box_union(leafBox, nodes[child1].box)) + inheritance;
+        if (!is_leaf(&nodes[child1]))
+            cost1 -= box_perimeter(nodes[child1].box);
+        float cost2 = box_perimeter(box_union(leafBox, nodes[child2].box)) + inheritance;
+        if (!is_leaf(&nodes[child2]))
+            cost2 -= box_perimeter(nodes[child2].box);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    // Un nuovo genitore prende il posto del fratello
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocate_node(tree);
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = box_union(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+    replace_child(tree, oldParent, sibling, newParent);
+
+    for (index = nodes[leaf].parent; index != AABB_TREE_NULL; index = nodes[index].parent)
+    {
+        index = balance(tree, index);
+        refit(tree, index);
+    }
+}
+
+static void remove_leaf(AabbTree *tree, int leaf)
+{
+    AabbNode *nodes = tree->nodes;
+    if (leaf == tree->root)
+    {
+        tree->root = AABB_TREE_NULL;
+        return;
+    }
+
+    // Il fratello prende il posto del genitore, che si libera
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    replace_child(tree, grandParent, parent, sibling);
+    nodes[sibling].parent = grandParent;
+    free_node(tree, parent);
+
+    for (int index = grandParent; index != AABB_TREE_NULL; index = nodes[index].parent)
+    {
+        index = balance(tree, index);
+        refit(tree, index);
+    }
+}
+
+static bool push(AabbTree *tree, int *count, int node)
+{
+    if (*count == tree->stackCapacity)
+    {
+        int capacity = tree->stackCapacity ? tree->stackCapacity * 2 : 64;
+        int *stack = realloc(tree->stack, (size_t)capacity * sizeof(int));
+        if (!stack)
+        {
+            perror("Memory allocation failed");
+            return false;
+        }
+        tree->stack = stack;
+        tree->stackCapacity = capacity;
+    }
+    tree->stack[(*count)++] = node;
+    return true;
+}
+
+void aabb_tree_init(AabbTree *tree, float margin)
+{
+    memset(tree, 0, sizeof(*tree));
+    tree->root = AABB_TREE_NULL;
+    tree->freeList = AABB_TREE_NULL;
+    tree->margin = margin;
+}
+
+void aabb_tree_free(AabbTree *tree)
+{
+    free(tree->nodes);
+    free(tree->stack);
+    aabb_tree_init(tree, tree->margin);
+}
+
+int aabb_tree_create_proxy(AabbTree *tree, float x, float y, float width, float height, uint32_t category, int user)
+{
+    // La foglia e il genitore che insert_leaf le crea: dopo non si può più fallire
+    if (tree->nodeCount + 2 > tree->nodeCapacity && !grow_nodes(tree))
+        return AABB_TREE_NULL;
+    int proxy = allocate_node(tree);
+    AabbNode *node = &tree->nodes[proxy];
+    float r = tree->margin;
+    node->box = (Aabb){x - r, y - r, x + width + r, y + height + r};
+    node->category = category;
+    node->user = user;
+    insert_leaf(tree, proxy);
+    return proxy;
+}
+
+void aabb_tree_destroy_proxy(AabbTree *tree, int proxy)
+{
+    if (proxy == AABB_TREE_NULL)
+        return;
+    remove_leaf(tree, proxy);
+    free_node(tree, proxy);
+}
+
+bool aabb_tree_move_proxy(AabbTree *tree, int proxy, float x, float y, float width, float height, float dx,
+                          float dy)
+{
+    float r = tree->margin;
+    Aabb tight = make_box(x, y, width, height);
+    Aabb fat = {tight.minX - r, tight.minY - r, tight.maxX + r, tight.maxY + r};
+    dx *= AABB_TREE_DISPLACEMENT_MULTIPLIER;
+    dy *= AABB_TREE_DISPLACEMENT_MULTIPLIER;
+    if (dx < 0.0f)
+        fat.minX += dx;
+    else
+        fat.maxX += dx;
+    if (dy < 0.0f)
+        fat.minY += dy;
+    else
+        fat.maxY += dy;
+
+    Aabb current = tree->nodes[proxy].box;
+    if (box_contains(current, tight))
+    {
+        // Ci sta ancora: si reinserisce solo se il box grasso è diventato troppo largo,
+        // per esempio dopo che l'entità ha rallentato
+        Aabb huge = {fat.minX - 4.0f * r, fat.minY - 4.0f * r, fat.maxX + 4.0f * r, fat.maxY + 4.0f * r};
+        if (box_contains(huge, current))
+            return false;
+    }
+
+    remove_leaf(tree, proxy);
+    tree->nodes[proxy].box = fat;
+    insert_leaf(tree, proxy);
+    return true;
+}
+
+void aabb_tree_query_box(AabbTree *tree, float x, float y, float width, float height, uint32_t categories,
+                         AabbTreeQueryCallback callback, void *context)
+{
+    if (tree->root == AABB_TREE_NULL)
+        return;
+    Aabb query = make_box(x, y, width, height);
+    int count = 0;
+    push(tree, &count, tree->root);
+    while (count > 0)
+    {
+        const AabbNode *node = &tree->nodes[tree->stack[--count]];
+        if (!(node->category & categories) || !box_overlap(node->box, query))
+            continue;
+        if (is_leaf(node))
+        {
+            if (!callback(context, (int)(node - tree->nodes)))
+                return;
+        }
+        else if (!push(tree, &count, node->child1) || !push(tree, &count, node->child2))
+        {
+            return;
+        }
+    }
+}
+
+void aabb_tree_query_point(AabbTree *tree, float x, float y, uint32_t categories, AabbTreeQueryCallback callback,
+                           void *context)
+{
+    aabb_tree_query_box(tree, x, y, 0.0f, 0.0f, categories, callback, context);
+}
+
+void aabb_tree_ray_cast(AabbTree *tree, float x0, float y0, float x1, float y1, uint32_t categories,
+                        AabbTreeRayCallback callback, void *context)
+{
+    if (tree->root == AABB_TREE_NULL)
+        return;
+    float rx = x1 - x0, ry = y1 - y0;
+    float length = sqrtf(rx * rx + ry * ry);
+    if (length == 0.0f)
+        return;
+    // Normale del segmento: un box è scartato se il suo centro dista dalla retta più
+    // della sua proiezione sulla normale
+    float vx = -ry / length, vy = rx / length;
+    float maxFraction = 1.0f;
+    Aabb segment = {fminf(x0, x1), fminf(y0, y1), fmaxf(x0, x1), fmaxf(y0, y1)};
+
+    int count = 0;
+    push(tree, &count, tree->root);
+    while (count > 0)
+    {
+        int index = tree->stack[--count];
+        const AabbNode *node = &tree->nodes[index];
+        if (!(node->category & categories) || !box_overlap(node->box, segment))
+            continue;
+        float cx = 0.5f * (node->box.minX + node->box.maxX), cy = 0.5f * (node->box.minY + node->box.maxY);
+        float hx = 0.5f * (node->box.maxX - node->box.minX), hy = 0.5f * (node->box.maxY - node->box.minY);
+        if (fabsf(vx * (x0 - cx) + vy * (y0 - cy)) - (fabsf(vx) * hx + fabsf(vy) * hy) > 0.0f)
+            continue;
+
+        if (!is_leaf(node))
+        {
+            if (!push(tree, &count, node->child1) || !push(tree, &count, node->child2))
+                return;
+            continue;
+        }
+        float value = callback(context, index, x0, y0, x1, y1, maxFraction);
+        if (value == 0.0f)
+            return;
+        if (value > 0.0f && value < maxFraction)
+        {
+            // Il resto del segmento non serve più: il box di scarto si accorcia
+            maxFraction = value;
+            float ex = x0 + rx * maxFraction, ey = y0 + ry * maxFraction;
+            segment = (Aabb){fminf(x0, ex), fminf(y0, ey), fmaxf(x0, ex), fmaxf(y0, ey)};
+        }
+    }
+}
+
+int aabb_tree_height(const AabbTree *tree)
+{
+    return tree->root == AABB_TREE_NULL ? 0 : tree->nodes[tree->root].height;
+}
+
+bool aabb_segment_fraction(const Aabb *box, float x0, float y0, float x1, float y1, float *fraction)
+{
+    // Slab test: l'intervallo di t in cui il segmento sta dentro ciascuna coppia di lati
+    float tMin = 0.0f, tMax = 1.0f;
+    const float origin[2] = {x0, y0};
+    const float delta[2] = {x1 - x0, y1 - y0};
+    const float lo[2] = {box->minX, box->minY};
+    const float hi[2] = {box->maxX, box->maxY};
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (delta[axis] == 0.0f)
+        {
+            if (origin[axis] < lo[axis] || origin[axis] > hi[axis])
+                return false;
+            continue;
+        }
+        float inv = 1.0f / delta[axis];
+        float t0 = (lo[axis] - origin[axis]) * inv;
+        float t1 = (hi[axis] - origin[axis]) * inv;
+        if (t0 > t1)
+        {
+            float t = t0;
+            t0 = t1;
+            t1 = t;
+        }
+        tMin = fmaxf(tMin, t0);
+        tMax = fminf(tMax, t1);
+        if (tMin > tMax)
+            return false;
+    }
+    *fraction = tMin;
+    return true;
+}
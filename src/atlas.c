@@ -0,0 +1,183 @@
+#include "atlas.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(AtlasRegion) == 64, "il manifest assume record da 64 byte");
+
+// Chiave di AtlasCorner: ordinarle vuol dire ordinare per layer, riga e colonna
+static uint64_t corner_key(uint32_t layer, uint32_t x, uint32_t y)
+{
+    return (uint64_t)layer << 32 | (uint64_t)y << 16 | x;
+}
+
+static int compare_corners(const void *a, const void *b)
+{
+    uint64_t ka = ((const AtlasCorner *)a)->corner, kb = ((const AtlasCorner *)b)->corner;
+    return ka < kb ? -1 : ka > kb;
+}
+
+bool atlas_load(Atlas *atlas, const char *path)
+{
+    memset(atlas, 0, sizeof(*atlas));
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false; // nessun atlas: il chiamante decide il fallback
+
+    AtlasHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != ATLAS_MAGIC || header.version != ATLAS_VERSION)
+    {
+        fprintf(stderr, "Manifest dell'atlas non valido: %s\n", path);
+        fclose(file);
+        return false;
+    }
+
+    atlas->regions = malloc(header.regionCount * sizeof(AtlasRegion));
+    if (header.regionCount && !atlas->regions)
+    {
+        perror("Memory allocation failed");
+        fclose(file);
+        return false;
+    }
+    if (fread(atlas->regions, sizeof(AtlasRegion), header.regionCount, file) != header.regionCount)
+    {
+        fprintf(stderr, "Manifest dell'atlas troncato: %s\n", path);
+        free(atlas->regions);
+        atlas->regions = NULL;
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
+    for (uint32_t i = 0; i < header.regionCount; i++)
+    {
+        atlas->regions[i].name[ATLAS_NAME_LENGTH - 1] = '\0';
+    }
+    atlas->layerWidth = header.layerWidth;
+    atlas->layerHeight = header.layerHeight;
+    atlas->layerCount = header.layerCount;
+    atlas->regionCount = header.regionCount;
+    atlas->padding = header.padding;
+
+    atlas->corners = malloc(header.regionCount * sizeof(AtlasCorner));
+    if (header.regionCount && !atlas->corners)
+    {
+        perror("Memory allocation failed");
+        atlas_free(atlas);
+        return false;
+    }
+    for (uint32_t i = 0; i < header.regionCount; i++)
+    {
+        const AtlasRegion *region = &atlas->regions[i];
+        atlas->corners[i] = (AtlasCorner){corner_key(region->layer, region->x, region->y), i};
+    }
+    qsort(atlas->corners, header.regionCount, sizeof(AtlasCorner), compare_corners);
+    return true;
+}
+
+static int compare_regions(const void *a, const void *b)
+{
+    return strcmp(((const AtlasRegion *)a)->name, ((const AtlasRegion *)b)->name);
+}
+
+bool atlas_save(Atlas *atlas, const char *path)
+{
+    qsort(atlas->regions, atlas->regionCount, sizeof(AtlasRegion), compare_regions);
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        perror("Failed to open file");
+        return false;
+    }
+    AtlasHeader header = {ATLAS_MAGIC, ATLAS_VERSION, atlas->layerWidth, atlas->layerHeight,
+                          atlas->layerCount, atlas->regionCount, atlas->padding};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(atlas->regions, sizeof(AtlasRegion), atlas->regionCount, file) == atlas->regionCount;
+    if (fclose(file) != 0)
+        ok = false;
+    return ok;
+}
+
+void atlas_free(Atlas *atlas)
+{
+    free(atlas->regions);
+    free(atlas->corners);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+void atlas_layer_path(const char *manifestPath, int layer, char *out, size_t size)
+{
+    const char *slash = strrchr(manifestPath, '/');
+    int directoryLength = slash ? (int)(slash - manifestPath) + 1 : 0;
+    snprintf(out, size, "%.*slayer_%d.png", directoryLength, manifestPath, layer);
+}
+
+int atlas_mip_levels(const Atlas *atlas)
+{
+    int levels = 1;
+    while (levels < 31 && (1u << levels) <= atlas->padding)
+        levels++;
+    return levels;
+}
+
+const AtlasRegion *atlas_find(const Atlas *atlas, const char *name)
+{
+    size_t lo = 0, hi = atlas->regionCount;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        int order = strcmp(atlas->regions[mid].name, name);
+        if (order == 0)
+            return &atlas->regions[mid];
+        if (order < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+const AtlasRegion *atlas_find_uv(const Atlas *atlas, int layer, const vec2 uvStart, const vec2 uvEnd)
+{
+    // sprite_set_region scrive x / layerWidth: arrotondando si ritrova il pixel esatto
+    long x = lroundf(uvStart[0] * atlas->layerWidth);
+    long y = lroundf(uvStart[1] * atlas->layerHeight);
+    if (!atlas->corners || layer < 0 || x < 0 || y < 0 || x > UINT16_MAX || y > UINT16_MAX)
+        return NULL;
+    uint64_t key = corner_key((uint32_t)layer, (uint32_t)x, (uint32_t)y);
+    size_t lo = 0, hi = atlas->regionCount;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        uint64_t corner = atlas->corners[mid].corner;
+        if (corner == key)
+        {
+            const AtlasRegion *region = &atlas->regions[atlas->corners[mid].region];
+            long x1 = lroundf(uvEnd[0] * atlas->layerWidth);
+            long y1 = lroundf(uvEnd[1] * atlas->layerHeight);
+            bool inside = x1 > x && y1 > y && x1 <= region->x + region->width && y1 <= region->y + region->height;
+            return inside ? region : NULL;
+        }
+        if (corner < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+bool sprite_set_region(Sprite *sprite, const Atlas *atlas, const char *name)
+{
+    const AtlasRegion *region = atlas_find(atlas, name);
+    if (!region)
+        return false;
+
+    sprite->uvStart[0] = (float)region->x / atlas->layerWidth;
+    sprite->uvStart[1] = (float)region->y / atlas->layerHeight;
+    sprite->uvEnd[0] = (float)(region->x + region->width) / atlas->layerWidth;
+    sprite->uvEnd[1] = (float)(region->y + region->height) / atlas->layerHeight;
+    sprite->layerIndex = (float)region->layer;
+    return true;
+}
@@ -0,0 +1,172 @@
+#include "cull.h"
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CULL_X86 1
+#endif
+
+// I kernel SIMD leggono i campi direttamente dall'array di Sprite (AoS da 16 float)
+#define SPRITE_FLOATS (sizeof(Sprite) / sizeof(float))
+#define FIELD(name) (offsetof(Sprite, name) / sizeof(float))
+
+_Static_assert(sizeof(Sprite) == 16 * sizeof(float), "i kernel di culling assumono Sprite da 64 byte");
+_Static_assert(FIELD(size) == FIELD(position) + 2, "position e size devono essere contigui");
+_Static_assert(FIELD(parallaxFactorX) == FIELD(rotation) + 1 && FIELD(parallaxFactorY) == FIELD(rotation) + 2,
+               "rotation e parallasse devono essere contigui");
+
+bool cull_sprite_visible(const Sprite *sprite, const CullView *view)
+{
+    float cx = sprite->position[0] - view->cameraX * sprite->parallaxFactorX;
+    float cy = sprite->position[1] - view->cameraY * sprite->parallaxFactorY;
+    float hx = 0.5f * sprite->size[0];
+    float hy = 0.5f * sprite->size[1];
+    if (sprite->rotation != 0.0f)
+    {
+        // Cerchio circoscritto: copre il quad per qualsiasi angolo
+        hx = hy = 0.5f * sqrtf(sprite->size[0] * sprite->size[0] + sprite->size[1] * sprite->size[1]);
+    }
+    return cx + hx >= 0.0f && cx - hx <= view->width &&
+           cy + hy >= 0.0f && cy - hy <= view->height;
+}
+
+size_t cull_sprites_scalar(const Sprite *sprites, size_t count, const CullView *view, uint32_t *visible)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (cull_sprite_visible(&sprites[i], view))
+            visible[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+#ifdef CULL_X86
+
+// Scrive gli indici dei bit accesi di mask (uno per sprite, a partire da first)
+static inline size_t emit_mask(unsigned mask, size_t first, uint32_t *visible, size_t n)
+{
+    while (mask)
+    {
+        visible[n++] = (uint32_t)(first + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return n;
+}
+
+// 4 sprite alla volta: due trasposizioni 4x4 portano i campi AoS in registri SoA
+static inline unsigned cull4_sse(const Sprite *s, __m128 camX, __m128 camY, __m128 width, __m128 height)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    __m128 px = _mm_loadu_ps(&s[0].position[0]); // x, y, w, h
+    __m128 py = _mm_loadu_ps(&s[1].position[0]);
+    __m128 w = _mm_loadu_ps(&s[2].position[0]);
+    __m128 h = _mm_loadu_ps(&s[3].position[0]);
+    _MM_TRANSPOSE4_PS(px, py, w, h);
+
+    __m128 rot = _mm_loadu_ps(&s[0].rotation); // rotation, parX, parY, color[0]
+    __m128 parX = _mm_loadu_ps(&s[1].rotation);
+    __m128 parY = _mm_loadu_ps(&s[2].rotation);
+    __m128 unused = _mm_loadu_ps(&s[3].rotation);
+    _MM_TRANSPOSE4_PS(rot, parX, parY, unused);
+    (void)unused;
+
+    __m128 cx = _mm_sub_ps(px, _mm_mul_ps(camX, parX));
+    __m128 cy = _mm_sub_ps(py, _mm_mul_ps(camY, parY));
+
+    __m128 radius = _mm_mul_ps(half, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(h, h))));
+    __m128 rotated = _mm_cmpneq_ps(rot, zero);
+    __m128 hx = _mm_or_ps(_mm_and_ps(rotated, radius), _mm_andnot_ps(rotated, _mm_mul_ps(half, w)));
+    __m128 hy = _mm_or_ps(_mm_and_ps(rotated, radius), _mm_andnot_ps(rotated, _mm_mul_ps(half, h)));
+
+    __m128 vis = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(cx, hx), zero), _mm_cmple_ps(_mm_sub_ps(cx, hx), width));
+    vis = _mm_and_ps(vis, _mm_cmpge_ps(_mm_add_ps(cy, hy), zero));
+    vis = _mm_and_ps(vis, _mm_cmple_ps(_mm_sub_ps(cy, hy), height));
+    return (unsigned)_mm_movemask_ps(vis);
+}
+
+static size_t cull_sprites_sse(const Sprite *sprites, size_t count, const CullView *view, uint32_t *visible)
+{
+    const __m128 camX = _mm_set1_ps(view->cameraX);
+    const __m128 camY = _mm_set1_ps(view->cameraY);
+    const __m128 width = _mm_set1_ps(view->width);
+    const __m128 height = _mm_set1_ps(view->height);
+
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        unsigned mask = cull4_sse(&sprites[i], camX, camY, width, height) |
+                        cull4_sse(&sprites[i + 4], camX, camY, width, height) << 4;
+        n = emit_mask(mask, i, visible, n);
+    }
+    for (; i < count; i++)
+    {
+        if (cull_sprite_visible(&sprites[i], view))
+            visible[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+__attribute__((target("avx2"))) static size_t cull_sprites_avx2(const Sprite *sprites, size_t count, const CullView *view, uint32_t *visible)
+{
+    const __m256 camX = _mm256_set1_ps(view->cameraX);
+    const __m256 camY = _mm256_set1_ps(view->cameraY);
+    const __m256 width = _mm256_set1_ps(view->width);
+    const __m256 height = _mm256_set1_ps(view->height);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    // Un lane per sprite: passo di SPRITE_FLOATS float
+    const __m256i lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)SPRITE_FLOATS));
+
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const float *base = (const float *)&sprites[i];
+        __m256 px = _mm256_i32gather_ps(base + FIELD(position), lanes, 4);
+        __m256 py = _mm256_i32gather_ps(base + FIELD(position) + 1, lanes, 4);
+        __m256 w = _mm256_i32gather_ps(base + FIELD(size), lanes, 4);
+        __m256 h = _mm256_i32gather_ps(base + FIELD(size) + 1, lanes, 4);
+        __m256 rot = _mm256_i32gather_ps(base + FIELD(rotation), lanes, 4);
+        __m256 parX = _mm256_i32gather_ps(base + FIELD(parallaxFactorX), lanes, 4);
+        __m256 parY = _mm256_i32gather_ps(base + FIELD(parallaxFactorY), lanes, 4);
+
+        __m256 cx = _mm256_sub_ps(px, _mm256_mul_ps(camX, parX));
+        __m256 cy = _mm256_sub_ps(py, _mm256_mul_ps(camY, parY));
+
+        __m256 radius = _mm256_mul_ps(half, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(w, w), _mm256_mul_ps(h, h))));
+        __m256 rotated = _mm256_cmp_ps(rot, zero, _CMP_NEQ_UQ);
+        __m256 hx = _mm256_blendv_ps(_mm256_mul_ps(half, w), radius, rotated);
+        __m256 hy = _mm256_blendv_ps(_mm256_mul_ps(half, h), radius, rotated);
+
+        __m256 vis = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(cx, hx), zero, _CMP_GE_OQ),
+                                   _mm256_cmp_ps(_mm256_sub_ps(cx, hx), width, _CMP_LE_OQ));
+        vis = _mm256_and_ps(vis, _mm256_cmp_ps(_mm256_add_ps(cy, hy), zero, _CMP_GE_OQ));
+        vis = _mm256_and_ps(vis, _mm256_cmp_ps(_mm256_sub_ps(cy, hy), height, _CMP_LE_OQ));
+
+        n = emit_mask((unsigned)_mm256_movemask_ps(vis), i, visible, n);
+    }
+    for (; i < count; i++)
+    {
+        if (cull_sprite_visible(&sprites[i], view))
+            visible[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+#endif // CULL_X86
+
+size_t cull_sprites(const Sprite *sprites, size_t count, const CullView *view, uint32_t *visible)
+{
+#ifdef CULL_X86
+    if (__builtin_cpu_supports("avx2"))
+        return cull_sprites_avx2(sprites, count, view, visible);
+    return cull_sprites_sse(sprites, count, view, visible);
+#else
+    return cull_sprites_scalar(sprites, count, view, visible);
+#endif
+}
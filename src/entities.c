@@ -2,11 +2,16 @@
 // entities.c
 #include "entities.h"
 #include <string.h>
+#include <stdio.h>
 #include <stdlib.h>
 
-void init_game_world(GameWorld *world)
+void init_game_world(GameWorld *world, CollisionBroadphase broadphase)
 {
     memset(world, 0, sizeof(GameWorld));
+    world->broadphase = broadphase;
+    aabb_tree_init(&world->collision_tree, COLLISION_TREE_MARGIN);
+    for (size_t i = 0; i < MAX_STATIC_OBJECTS; i++)
+        world->decorazioni_proxy[i] = AABB_TREE_NULL;
     for (size_t i = 0; i < 200; ++i)
     {
         size_t px = i % 30;
@@ -18,6 +23,108 @@ void init_game_world(GameWorld *world)
         sprite_init(&world->decorazioni[i], 20.0f + px * 40.0f, 20.0f + py * 40.0f, 32.0f, 32.0f, uvStart, uvEnd, layerIndex, parallax, parallax, parallax);
     }
     (*world).count_decorazioni = 200;
+    mark_decorazioni_dirty(world, 0, world->count_decorazioni);
+
+    // Stanza di prova: pavimento e qualche piattaforma con le celle del layer 1
+    TileMap *map = &world->tilemap;
+    if (tilemap_init(map, 160, 23, 1, 8, 0.75f))
+    {
+        tilemap_fill(map, 0, 19, map->width, map->height, 1 + 8); // cella (0, 1)
+        tilemap_fill(map, 0, 18, map->width, 19, 1);              // cella (0, 0), bordo superiore
+        for (int x = 12; x < map->width; x += 24)
+        {
+            tilemap_fill(map, x, 12, x + 6, 13, 2);
+        }
+        solid_grid_build(&world->solids, map);
+    }
+    // Nemici e proiettili sono di 32 e 8 unità: una cella di 64 ne contiene pochi
+    world->collision_cell_size = 64.0f;
+    spatial_grid_init(&world->enemy_grid, world->collision_cell_size);
+    sweep_prune_init(&world->sweep_prune);
+}
+
+void free_game_world(GameWorld *world)
+{
+    tilemap_free(&world->tilemap);
+    solid_grid_free(&world->solids);
+    spatial_grid_free(&world->enemy_grid);
+    sweep_prune_free(&world->sweep_prune);
+    aabb_tree_free(&world->collision_tree);
+    free(world->collision_hits);
+    world->collision_hits = NULL;
+    world->collision_hit_capacity = 0;
+}
+
+// Con la sweep and prune ogni entità ha un proxy dalla creazione alla rimozione
+static int add_collision_proxy(GameWorld *world, const Transform *t, uint32_t category, uint32_t mask, int index)
+{
+    if (world->broadphase != COLLISION_SWEEP_PRUNE)
+        return -1;
+    return sweep_prune_add(&world->sweep_prune, t->x, t->y, t->width, t->height, category, mask, index);
+}
+
+// Box di una decorazione: position è il centro, e ruotata si prende il cerchio che la contiene
+static Transform decorazione_box(const EntitaStatica *decorazione)
+{
+    float hx = 0.5f * decorazione->size[0], hy = 0.5f * decorazione->size[1];
+    if (decorazione->rotation != 0.0f)
+        hx = hy = sqrtf(hx * hx + hy * hy);
+    return (Transform){decorazione->position[0] - hx, decorazione->position[1] - hy, 2.0f * hx, 2.0f * hy};
+}
+
+// Solo le decorazioni sul piano di gioco sono solidi: le altre scorrono con la parallasse
+static void sync_decorazione_proxy(GameWorld *world, size_t i)
+{
+    const EntitaStatica *decorazione = &world->decorazioni[i];
+    int *proxy = &world->decorazioni_proxy[i];
+    bool solid = decorazione->parallaxFactorX == 1.0f && decorazione->parallaxFactorY == 1.0f;
+    if (!solid)
+    {
+        aabb_tree_destroy_proxy(&world->collision_tree, *proxy);
+        *proxy = AABB_TREE_NULL;
+        return;
+    }
+    Transform box = decorazione_box(decorazione);
+    if (*proxy == AABB_TREE_NULL)
+        *proxy = aabb_tree_create_proxy(&world->collision_tree, box.x, box.y, box.width, box.height,
+                                        COLLISION_SOLID, (int)i);
+    else
+        aabb_tree_move_proxy(&world->collision_tree, *proxy, box.x, box.y, box.width, box.height, 0.0f, 0.0f);
+}
+
+void mark_decorazioni_dirty(GameWorld *world, size_t first, size_t count)
+{
+    if (count == 0)
+        return;
+
+    size_t last = first + count;
+    // L'albero segue le decorazioni modificate subito, la GPU al prossimo upload
+    for (size_t i = first; i < last && i < world->count_decorazioni; i++)
+        sync_decorazione_proxy(world, i);
+    if (world->decorazioni_dirty_begin == world->decorazioni_dirty_end)
+    {
+        world->decorazioni_dirty_begin = first;
+        world->decorazioni_dirty_end = last;
+        return;
+    }
+    if (first < world->decorazioni_dirty_begin)
+        world->decorazioni_dirty_begin = first;
+    if (last > world->decorazioni_dirty_end)
+        world->decorazioni_dirty_end = last;
+}
+
+// Transform è la copia in float della posizione al pixel, per il rendering e le collisioni
+static void sync_actor_transform(Transform *transform, const Actor *body)
+{
+    transform->x = (float)body->x;
+    transform->y = (float)body->y;
+    transform->width = (float)body->width;
+    transform->height = (float)body->height;
+}
+
+static MoveContext move_context(const GameWorld *world)
+{
+    return (MoveContext){&world->solids, world->platforms, world->platform_count};
 }
 
 Player *create_player(GameWorld *world, float x, float y)
@@ -42,15 +149,18 @@ Enemy *create_enemy(GameWorld *world, float x, float y)
         return NULL;
 
     Enemy *enemy = &world->enemies[world->enemy_count++];
-    enemy->transform.x = x;
-    enemy->transform.y = y;
-    enemy->transform.width = 32;
-    enemy->transform.height = 32;
+    actor_init(&enemy->body, x, y, 32, 32);
+    sync_actor_transform(&enemy->transform, &enemy->body);
     enemy->speed = 100.0f;
     enemy->damage = 10;
     enemy->patrol_range = 100.0f;
-    enemy->patrol_start_x = x;
+    enemy->patrol_start_x = enemy->transform.x;
     enemy->is_active = true;
+    enemy->proxy = add_collision_proxy(world, &enemy->transform, COLLISION_ENEMY, COLLISION_PROJECTILE,
+                                       world->enemy_count - 1);
+    enemy->tree_proxy = aabb_tree_create_proxy(&world->collision_tree, enemy->transform.x, enemy->transform.y,
+                                               enemy->transform.width,
+                                               enemy->transform.height, COLLISION_ENEMY, world->enemy_count - 1);
 
     return enemy;
 }
@@ -61,15 +171,19 @@ Projectile *create_projectile(GameWorld *world, float x, float y, float dir_x, f
         return NULL;
 
     Projectile *projectile = &world->projectiles[world->projectile_count++];
-    projectile->transform.x = x;
-    projectile->transform.y = y;
-    projectile->transform.width = 8;
-    projectile->transform.height = 8;
+    actor_init(&projectile->body, x, y, 8, 8);
+    sync_actor_transform(&projectile->transform, &projectile->body);
     projectile->speed = 300.0f;
     projectile->direction_x = dir_x;
     projectile->direction_y = dir_y;
     projectile->damage = 20;
     projectile->is_active = true;
+    projectile->proxy = add_collision_proxy(world, &projectile->transform, COLLISION_PROJECTILE, COLLISION_ENEMY,
+                                            world->projectile_count - 1);
+    projectile->tree_proxy = aabb_tree_create_proxy(&world->collision_tree, projectile->transform.x,
+                                                    projectile->transform.y, projectile->transform.width,
+                                                    projectile->transform.height, COLLISION_PROJECTILE,
+                                                    world->projectile_count - 1);
 
     return projectile;
 }
@@ -82,7 +196,17 @@ void update_player(Player *player, float delta_time)
     // Ad esempio: input da tastiera, limiti dello schermo, ecc.
 }
 
-void update_enemy(Enemy *enemy, float delta_time)
+Solid *create_platform(GameWorld *world, float x, float y, int width, int height)
+{
+    if (world->platform_count >= MAX_PLATFORMS)
+        return NULL;
+
+    Solid *platform = &world->platforms[world->platform_count++];
+    solid_init(platform, x, y, width, height);
+    return platform;
+}
+
+void update_enemy(GameWorld *world, Enemy *enemy, float delta_time)
 {
     if (!enemy->is_active)
         return;
@@ -93,16 +217,28 @@ void update_enemy(Enemy *enemy, float delta_time)
     {
         enemy->speed = -enemy->speed; // Inverti direzione
     }
-    enemy->transform.x += enemy->speed * delta_time;
+    MoveContext context = move_context(world);
+    if (!actor_move_x(&context, &enemy->body, enemy->speed * delta_time))
+    {
+        enemy->speed = -enemy->speed; // Contro un muro torna indietro come a fine pattuglia
+    }
+    sync_actor_transform(&enemy->transform, &enemy->body);
 }
 
-void update_projectile(Projectile *projectile, float delta_time)
+void update_projectile(GameWorld *world, Projectile *projectile, float delta_time)
 {
     if (!projectile->is_active)
         return;
 
-    projectile->transform.x += projectile->direction_x * projectile->speed * delta_time;
-    projectile->transform.y += projectile->direction_y * projectile->speed * delta_time;
+    // Il proiettile si ferma sul primo solido che tocca
+    MoveContext context = move_context(world);
+    float step = projectile->speed * delta_time;
+    if (!actor_move_x(&context, &projectile->body, projectile->direction_x * step) ||
+        !actor_move_y(&context, &projectile->body, projectile->direction_y * step))
+    {
+        projectile->is_active = false;
+    }
+    sync_actor_transform(&projectile->transform, &projectile->body);
 
     // Disattiva il proiettile se esce dallo schermo
     // Sostituisci SCREEN_WIDTH e SCREEN_HEIGHT con i valori effettivi
@@ -121,21 +257,56 @@ void update_game_world(GameWorld *world, float delta_time)
 
     for (int i = 0; i < world->enemy_count; i++)
     {
-        update_enemy(&world->enemies[i], delta_time);
+        update_enemy(world, &world->enemies[i], delta_time);
     }
 
     for (int i = 0; i < world->projectile_count; i++)
     {
-        update_projectile(&world->projectiles[i], delta_time);
+        update_projectile(world, &world->projectiles[i], delta_time);
     }
 
-    // Gestisci le collisioni
+    // Gestisci le collisioni; l'albero si aggiorna a ogni frame solo se è la broadphase,
+    // altrimenti lo porta al passo la prima query che ne ha bisogno
+    world->collision_tree_dt = delta_time;
+    world->collision_tree_stale = true;
+    if (world->broadphase == COLLISION_AABB_TREE)
+        sync_collision_tree(world, delta_time);
     handle_collisions(world);
 
     // Rimuovi le entità inattive
     remove_inactive_entities(world);
 }
 
+void move_platform(GameWorld *world, Solid *platform, float dx, float dy)
+{
+    // Solo le entità attive vengono spinte o trasportate
+    int count = 0;
+    for (int i = 0; i < world->enemy_count; i++)
+        if (world->enemies[i].is_active)
+            world->platform_actors[count++] = &world->enemies[i].body;
+    for (int i = 0; i < world->projectile_count; i++)
+        if (world->projectiles[i].is_active)
+            world->platform_actors[count++] = &world->projectiles[i].body;
+
+    MoveContext context = move_context(world);
+    solid_move(&context, platform, dx, dy, world->platform_actors, count);
+
+    for (int i = 0; i < world->enemy_count; i++)
+    {
+        Enemy *enemy = &world->enemies[i];
+        sync_actor_transform(&enemy->transform, &enemy->body);
+        if (enemy->body.squished)
+            enemy->is_active = false;
+    }
+    for (int i = 0; i < world->projectile_count; i++)
+    {
+        Projectile *projectile = &world->projectiles[i];
+        sync_actor_transform(&projectile->transform, &projectile->body);
+        if (projectile->body.squished)
+            projectile->is_active = false;
+    }
+}
+
 bool check_collision(Transform *a, Transform *b)
 {
     return (a->x < b->x + b->width &&
@@ -144,33 +315,282 @@ bool check_collision(Transform *a, Transform *b)
             a->y + a->height > b->y);
 }
 
-void handle_collisions(GameWorld *world)
+static void handle_collisions_grid(GameWorld *world)
 {
-    // Controlla collisioni proiettili-nemici
+    // La griglia dà per ogni proiettile solo i nemici vicini; tra quelli colpiti vale
+    // il primo per indice, come nel doppio ciclo
+    SpatialGrid *grid = &world->enemy_grid;
+    spatial_grid_clear(grid, world->collision_cell_size);
+    for (int j = 0; j < world->enemy_count; j++)
+    {
+        Transform *t = &world->enemies[j].transform;
+        if (world->enemies[j].is_active)
+            spatial_grid_insert(grid, j, t->x, t->y, t->width, t->height);
+    }
+    spatial_grid_build(grid);
+
+    int candidates[MAX_ENEMIES];
     for (int i = 0; i < world->projectile_count; i++)
     {
         if (!world->projectiles[i].is_active)
             continue;
 
-        for (int j = 0; j < world->enemy_count; j++)
+        Transform *t = &world->projectiles[i].transform;
+        int count = spatial_grid_query(grid, t->x, t->y, t->width, t->height, candidates, MAX_ENEMIES);
+        int hit = -1;
+        for (int c = 0; c < count; c++)
+        {
+            int j = candidates[c];
+            if ((hit < 0 || j < hit) && world->enemies[j].is_active &&
+                check_collision(t, &world->enemies[j].transform))
+                hit = j;
+        }
+        if (hit >= 0)
         {
-            if (!world->enemies[j].is_active)
-                continue;
+            // Gestisci la collisione
+            world->projectiles[i].is_active = false;
+            world->enemies[hit].is_active = false;
+        }
+    }
+}
 
-            if (check_collision(&world->projectiles[i].transform,
-                                &world->enemies[j].transform))
-            {
-                // Gestisci la collisione
-                world->projectiles[i].is_active = false;
-                world->enemies[j].is_active = false;
-                break;
-            }
+static int compare_hits(const void *pa, const void *pb)
+{
+    uint64_t a = *(const uint64_t *)pa, b = *(const uint64_t *)pb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void handle_collisions_sweep_prune(GameWorld *world)
+{
+    SweepPrune *sap = &world->sweep_prune;
+    for (int j = 0; j < world->enemy_count; j++)
+    {
+        Transform *t = &world->enemies[j].transform;
+        if (world->enemies[j].proxy >= 0)
+            sweep_prune_move(sap, world->enemies[j].proxy, t->x, t->y, t->width, t->height, j);
+    }
+    for (int i = 0; i < world->projectile_count; i++)
+    {
+        Transform *t = &world->projectiles[i].transform;
+        if (world->projectiles[i].proxy >= 0)
+            sweep_prune_move(sap, world->projectiles[i].proxy, t->x, t->y, t->width, t->height, i);
+    }
+    if (!sweep_prune_update(sap))
+        return;
+
+    // Le coppie che si sovrappongono, ordinate per proiettile e poi per nemico: ogni
+    // proiettile prende il primo nemico ancora attivo, come nel doppio ciclo
+    int pairCount, hitCount = 0;
+    const SweepPair *pairs = sweep_prune_pairs(sap, &pairCount);
+    if (pairCount > world->collision_hit_capacity)
+    {
+        uint64_t *hits = realloc(world->collision_hits, (size_t)pairCount * sizeof(uint64_t));
+        if (!hits)
+        {
+            perror("Memory allocation failed");
+            return;
+        }
+        world->collision_hits = hits;
+        world->collision_hit_capacity = pairCount;
+    }
+    for (int k = 0; k < pairCount; k++)
+    {
+        if (pairs[k].state == SWEEP_PAIR_END)
+            continue;
+        const SweepProxy *a = sweep_prune_proxy(sap, pairs[k].a);
+        const SweepProxy *b = sweep_prune_proxy(sap, pairs[k].b);
+        const SweepProxy *projectile = a->category == COLLISION_PROJECTILE ? a : b;
+        const SweepProxy *enemy = a->category == COLLISION_PROJECTILE ? b : a;
+        world->collision_hits[hitCount++] = (uint64_t)projectile->user << 32 | (uint32_t)enemy->user;
+    }
+    qsort(world->collision_hits, (size_t)hitCount, sizeof(uint64_t), compare_hits);
+
+    for (int k = 0; k < hitCount; k++)
+    {
+        Projectile *projectile = &world->projectiles[world->collision_hits[k] >> 32];
+        Enemy *enemy = &world->enemies[(uint32_t)world->collision_hits[k]];
+        if (projectile->is_active && enemy->is_active)
+        {
+            // Gestisci la collisione
+            projectile->is_active = false;
+            enemy->is_active = false;
+        }
+    }
+}
+
+typedef struct
+{
+    GameWorld *world;
+    Transform *box;
+    int hit; // indice del nemico, -1 se nessuno
+} EnemyHitQuery;
+
+static bool find_first_enemy(void *context, int proxy)
+{
+    EnemyHitQuery *query = context;
+    int j = aabb_tree_user(&query->world->collision_tree, proxy);
+    Enemy *enemy = &query->world->enemies[j];
+    if ((query->hit < 0 || j < query->hit) && enemy->is_active && check_collision(query->box, &enemy->transform))
+        query->hit = j;
+    return true;
+}
+
+static void handle_collisions_tree(GameWorld *world)
+{
+    // Come con la griglia: i nemici vicini dall'albero, tra quelli colpiti il primo per indice
+    for (int i = 0; i < world->projectile_count; i++)
+    {
+        if (!world->projectiles[i].is_active)
+            continue;
+
+        Transform *t = &world->projectiles[i].transform;
+        EnemyHitQuery query = {world, t, -1};
+        aabb_tree_query_box(&world->collision_tree, t->x, t->y, t->width, t->height, COLLISION_ENEMY,
+                            find_first_enemy, &query);
+        if (query.hit >= 0)
+        {
+            // Gestisci la collisione
+            world->projectiles[i].is_active = false;
+            world->enemies[query.hit].is_active = false;
         }
     }
+}
+
+void handle_collisions(GameWorld *world)
+{
+    // Controlla collisioni proiettili-nemici
+    if (world->broadphase == COLLISION_SWEEP_PRUNE)
+        handle_collisions_sweep_prune(world);
+    else if (world->broadphase == COLLISION_AABB_TREE)
+        handle_collisions_tree(world);
+    else
+        handle_collisions_grid(world);
 
     // Aggiungi altre verifiche di collisione secondo necessità
 }
 
+bool collide_rect(const GameWorld *world, int x, int y, int w, int h)
+{
+    return solid_grid_collide_rect(&world->solids, x, y, w, h);
+}
+
+void sync_collision_tree(GameWorld *world, float delta_time)
+{
+    // Lo spostamento previsto per il prossimo frame allunga i box grassi nella direzione del moto
+    AabbTree *tree = &world->collision_tree;
+    for (int j = 0; j < world->enemy_count; j++)
+    {
+        Enemy *enemy = &world->enemies[j];
+        Transform *t = &enemy->transform;
+        if (enemy->tree_proxy != AABB_TREE_NULL)
+            aabb_tree_move_proxy(tree, enemy->tree_proxy, t->x, t->y, t->width, t->height,
+                                 enemy->speed * delta_time, 0.0f);
+    }
+    for (int i = 0; i < world->projectile_count; i++)
+    {
+        Projectile *projectile = &world->projectiles[i];
+        Transform *t = &projectile->transform;
+        float step = projectile->speed * delta_time;
+        if (projectile->tree_proxy != AABB_TREE_NULL)
+            aabb_tree_move_proxy(tree, projectile->tree_proxy, t->x, t->y, t->width, t->height,
+                                 projectile->direction_x * step, projectile->direction_y * step);
+    }
+    world->collision_tree_stale = false;
+}
+
+static void ensure_collision_tree(GameWorld *world)
+{
+    if (world->collision_tree_stale)
+        sync_collision_tree(world, world->collision_tree_dt);
+}
+
+// Il box esatto dietro un proxy dell'albero
+static Transform proxy_box(const GameWorld *world, uint32_t category, int index)
+{
+    if (category == COLLISION_ENEMY)
+        return world->enemies[index].transform;
+    if (category == COLLISION_PROJECTILE)
+        return world->projectiles[index].transform;
+    return decorazione_box(&world->decorazioni[index]);
+}
+
+typedef struct
+{
+    GameWorld *world;
+    Transform box;
+    bool point;  // box di dimensioni nulle: contiene il punto se x in [box.x, box.x + width)
+    WorldHit *out;
+    int max, count;
+} WorldQuery;
+
+static bool collect_hit(void *context, int proxy)
+{
+    WorldQuery *query = context;
+    AabbTree *tree = &query->world->collision_tree;
+    WorldHit hit = {aabb_tree_category(tree, proxy), aabb_tree_user(tree, proxy)};
+    Transform box = proxy_box(query->world, hit.category, hit.index);
+    bool overlap = query->point ? query->box.x >= box.x && query->box.x < box.x + box.width &&
+                                      query->box.y >= box.y && query->box.y < box.y + box.height
+                                : check_collision(&query->box, &box);
+    if (!overlap)
+        return true;
+    if (query->count < query->max)
+        query->out[query->count] = hit;
+    query->count++;
+    return true;
+}
+
+int query_world_box(GameWorld *world, const Transform *box, uint32_t categories, WorldHit *out, int max)
+{
+    ensure_collision_tree(world);
+    WorldQuery query = {world, *box, false, out, max, 0};
+    aabb_tree_query_box(&world->collision_tree, box->x, box->y, box->width, box->height, categories, collect_hit,
+                        &query);
+    return query.count;
+}
+
+int query_world_point(GameWorld *world, float x, float y, uint32_t categories, WorldHit *out, int max)
+{
+    ensure_collision_tree(world);
+    WorldQuery query = {world, {x, y, 0.0f, 0.0f}, true, out, max, 0};
+    aabb_tree_query_point(&world->collision_tree, x, y, categories, collect_hit, &query);
+    return query.count;
+}
+
+typedef struct
+{
+    GameWorld *world;
+    WorldHit *hit;
+    float fraction;
+} WorldRay;
+
+static float clip_ray(void *context, int proxy, float x0, float y0, float x1, float y1, float maxFraction)
+{
+    WorldRay *ray = context;
+    AabbTree *tree = &ray->world->collision_tree;
+    WorldHit hit = {aabb_tree_category(tree, proxy), aabb_tree_user(tree, proxy)};
+    Transform t = proxy_box(ray->world, hit.category, hit.index);
+    Aabb box = {t.x, t.y, t.x + t.width, t.y + t.height};
+    float fraction;
+    if (!aabb_segment_fraction(&box, x0, y0, x1, y1, &fraction) || fraction >= maxFraction)
+        return -1.0f;
+    *ray->hit = hit;
+    ray->fraction = fraction;
+    return fraction; // 0 se il segmento parte dentro il box: più vicino di così non si può
+}
+
+bool raycast_world(GameWorld *world, float x0, float y0, float x1, float y1, uint32_t categories, WorldHit *hit,
+                   float *fraction)
+{
+    ensure_collision_tree(world);
+    WorldRay ray = {world, hit, 2.0f};
+    aabb_tree_ray_cast(&world->collision_tree, x0, y0, x1, y1, categories, clip_ray, &ray);
+    if (ray.fraction > 1.0f)
+        return false;
+    *fraction = ray.fraction;
+    return true;
+}
+
 void remove_inactive_entities(GameWorld *world)
 {
     // Rimuovi nemici inattivi
@@ -182,9 +602,16 @@ void remove_inactive_entities(GameWorld *world)
             if (i != active_enemies)
             {
                 world->enemies[active_enemies] = world->enemies[i];
+                if (world->enemies[active_enemies].tree_proxy != AABB_TREE_NULL)
+                    aabb_tree_set_user(&world->collision_tree, world->enemies[active_enemies].tree_proxy, active_enemies);
             }
             active_enemies++;
         }
+        else
+        {
+            sweep_prune_remove(&world->sweep_prune, world->enemies[i].proxy);
+            aabb_tree_destroy_proxy(&world->collision_tree, world->enemies[i].tree_proxy);
+        }
     }
     world->enemy_count = active_enemies;
 
@@ -197,9 +624,16 @@ void remove_inactive_entities(GameWorld *world)
             if (i != active_projectiles)
             {
                 world->projectiles[active_projectiles] = world->projectiles[i];
+                if (world->projectiles[active_projectiles].tree_proxy != AABB_TREE_NULL)
+                    aabb_tree_set_user(&world->collision_tree, world->projectiles[active_projectiles].tree_proxy, active_projectiles);
             }
             active_projectiles++;
         }
+        else
+        {
+            sweep_prune_remove(&world->sweep_prune, world->projectiles[i].proxy);
+            aabb_tree_destroy_proxy(&world->collision_tree, world->projectiles[i].tree_proxy);
+        }
     }
     world->projectile_count = active_projectiles;
 }
\ No newline at end of file
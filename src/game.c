@@ -4,9 +4,9 @@
 #include <GLFW/glfw3.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 Game game;
-Sprite drawing[16384];
 size_t count_drawing;
 bool keypressed[GLFW_KEY_LAST];
 
@@ -21,6 +21,11 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
         return;
     }
 
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+    {
+        renderer_cycle_cull_mode(&game.renderer); // nessuno -> CPU -> GPU
+    }
+
     if (action == GLFW_PRESS)
     {
         keypressed[key] = true;
@@ -31,10 +36,53 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
     }
 }
 
-bool init_game()
+// Risoluzione del framebuffer offscreen in modalità headless
+#define HEADLESS_WIDTH 1920
+#define HEADLESS_HEIGHT 1080
+// Headless deve dare sempre la stessa immagine: seme fisso e un passo da 1/60 di secondo per frame
+#define HEADLESS_SEED 1234u
+#define HEADLESS_TIMESTEP (1.0 / 60.0)
+
+// Opzioni da riga di comando: modalità del renderer (restituite come flag) e del gioco
+unsigned parse_options(int argc, char **argv)
 {
+    unsigned flags = 0;
+    const char *headless = getenv("MYGAME_HEADLESS");
+    game.headless = headless && headless[0] && strcmp(headless, "0") != 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--packed-instances") == 0)
+            flags |= RENDERER_PACKED_INSTANCES;
+        else if (strcmp(argv[i], "--vertex-pulling") == 0)
+            flags |= RENDERER_VERTEX_PULLING;
+        else if (strcmp(argv[i], "--hot-reload") == 0)
+            flags |= RENDERER_SHADER_HOT_RELOAD;
+        else if (strcmp(argv[i], "--sweep-prune") == 0)
+            game.broadphase = COLLISION_SWEEP_PRUNE;
+        else if (strcmp(argv[i], "--aabb-tree") == 0)
+            game.broadphase = COLLISION_AABB_TREE;
+        else if (strcmp(argv[i], "--headless") == 0)
+            game.headless = true;
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            game.frameLimit = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc)
+            game.screenshotPath = argv[++i];
+        else if (strcmp(argv[i], "--profile") == 0)
+            game.profile = true;
+        else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc)
+        {
+            game.profile = true;
+            game.profileCsvPath = argv[++i];
+        }
+        else
+            fprintf(stderr, "Opzione sconosciuta: %s\n", argv[i]);
+    }
+    return flags;
+}
 
-    srand(time(NULL)); // Seed the random number generator
+// Finestra fullscreen sul monitor primario, contesto corrente e GLAD caricato
+static bool open_window(void)
+{
     // --- GLFW Initialization --- (your boilerplate)
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -88,6 +136,36 @@ bool init_game()
         fprintf(stderr, "Failed to initialize GLAD\n");
         return false;
     }
+    return true;
+}
+
+bool init_game(int argc, char **argv)
+{
+
+    // La decodifica dei PNG parte subito e si sovrappone a finestra e contesto GL
+    static TextureLoader textures;
+    texture_loader_start(&textures, 0);
+    unsigned flags = parse_options(argc, argv);
+    srand(game.headless ? HEADLESS_SEED : (unsigned)time(NULL)); // Seed the random number generator
+
+    // Headless: contesto EGL senza superficie, il renderer disegna nel framebuffer offscreen
+    double phaseStart = clock_now_ms();
+    if (game.headless)
+    {
+        game.screenWidth = HEADLESS_WIDTH;
+        game.screenHeight = HEADLESS_HEIGHT;
+        if (!headless_init(&game.offscreen, game.screenWidth, game.screenHeight))
+        {
+            texture_loader_free(&textures); // i worker stanno ancora decodificando
+            return false;
+        }
+    }
+    else if (!open_window())
+    {
+        texture_loader_free(&textures);
+        return false;
+    }
+    double windowMs = clock_now_ms() - phaseStart;
 
     // printf("OpenGL Version: %s\n", glGetString(GL_VERSION));
     // printf("GLSL Version: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
@@ -95,8 +173,26 @@ bool init_game()
 
     game.running = true;
 
-    init_game_world(&game.world);
-    renderer_init(&game.renderer, 16384, game.screenWidth, game.screenHeight);
+    phaseStart = clock_now_ms();
+    init_game_world(&game.world, game.broadphase);
+    double worldMs = clock_now_ms() - phaseStart;
+
+    phaseStart = clock_now_ms();
+    if (!renderer_init(&game.renderer, 16384, game.screenWidth, game.screenHeight, flags, &textures))
+    {
+        fprintf(stderr, "Failed to initialize renderer\n");
+        texture_loader_free(&textures); // se renderer_init è uscito prima di consumarlo
+        return false;
+    }
+    double rendererMs = clock_now_ms() - phaseStart - textures.waitMs - textures.uploadMs;
+    if (game.profile && profiler_init(&game.profiler, game.profileCsvPath))
+        game.renderer.profiler = &game.profiler;
+
+    printf("Avvio %.1f ms: finestra e GLAD %.1f, mondo %.1f, renderer %.1f, "
+           "attesa texture %.1f, upload %.1f (%d layer, %d dalla cache: %.1f ms, %.1f ms di CPU)\n",
+           clock_now_ms() - textures.startTime, windowMs, worldMs, rendererMs,
+           textures.waitMs, textures.uploadMs, textures.layerCount, atomic_load(&textures.cacheHits),
+           textures.decodeWallMs, textures.decodeCpuNs / 1e6);
     return true;
 }
 
@@ -106,6 +202,7 @@ void update(float deltaTime)
     {
         sprite_update(&game.world.decorazioni[i], deltaTime);
     }
+    mark_decorazioni_dirty(&game.world, 0, 20);
     if (keypressed[GLFW_KEY_LEFT])
         game.camera_pos[0] -= 5.0f * deltaTime;
     if (keypressed[GLFW_KEY_RIGHT])
@@ -120,12 +217,58 @@ void render()
 {
 
     renderer_begin_frame(&game.renderer);
-    count_drawing = renderer_set_sprites(&game.world, drawing);
-    renderer_draw_sprites(&game.renderer, drawing, count_drawing);
+    // le decorazioni stanno nella regione statica: si caricano solo le parti modificate
+    renderer_sync_static(&game.renderer, &game.world);
+    renderer_sync_tilemap(&game.renderer, &game.world.tilemap);
+    // il gather scrive nello staging, il submit ordina e copia nella regione del ring
+    profiler_cpu_begin(&game.profiler, PROFILE_GATHER);
+    count_drawing = renderer_set_sprites(&game.renderer, &game.world, renderer_frame_instances(&game.renderer));
+    profiler_cpu_end(&game.profiler, PROFILE_GATHER);
+    profiler_cpu_begin(&game.profiler, PROFILE_SUBMIT);
+    renderer_submit_sprites(&game.renderer, renderer_frame_offset(&game.renderer), count_drawing);
+    profiler_cpu_end(&game.profiler, PROFILE_SUBMIT);
+    // prima gli opachi (front-to-back), poi i traslucidi con il blending (back-to-front);
+    // la stanza è opaca: pochi quad, uno per chunk visibile
+    renderer_draw_tilemap(&game.renderer, &game.world.tilemap);
+    renderer_draw_pass(&game.renderer, RENDER_PASS_OPAQUE);
+    renderer_draw_pass(&game.renderer, RENDER_PASS_TRANSLUCENT);
     renderer_end_frame(&game.renderer);
 }
 
+double game_time(void)
+{
+    return game.headless ? game.frameCount * HEADLESS_TIMESTEP : glfwGetTime();
+}
+
+void present_frame(void)
+{
+    if (game.headless)
+    {
+        glFlush(); // nessuno swap: il lavoro del frame parte comunque
+    }
+    else
+    {
+        glfwSwapBuffers(game.window);
+        glfwPollEvents();
+    }
+    game.frameCount++;
+    if (game.frameLimit > 0 && game.frameCount >= game.frameLimit)
+        game.running = false;
+}
+
 void cleanup()
 {
-    glfwTerminate();
+    free_game_world(&game.world);
+    profiler_free(&game.profiler);
+    profiler_print_summary(&game.profiler);
+    if (game.headless)
+    {
+        if (game.screenshotPath)
+            headless_save_ppm(&game.offscreen, game.screenshotPath);
+        headless_free(&game.offscreen);
+    }
+    else
+    {
+        glfwTerminate();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "headless.h"
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static EGLDisplay open_display(void)
+{
+    // Con Mesa la piattaforma surfaceless non ha bisogno né di X né di un DRM master
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool headless_init(HeadlessContext *headless, int width, int height)
+{
+    memset(headless, 0, sizeof(*headless));
+    headless->width = width;
+    headless->height = height;
+
+    headless->display = open_display();
+    EGLint major, minor;
+    if (headless->display == EGL_NO_DISPLAY || !eglInitialize(headless->display, &major, &minor))
+    {
+        fprintf(stderr, "Impossibile inizializzare EGL\n");
+        return false;
+    }
+    const char *extensions = eglQueryString(headless->display, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context"))
+    {
+        fprintf(stderr, "EGL_KHR_surfaceless_context non supportato\n");
+        eglTerminate(headless->display);
+        return false;
+    }
+
+    // Nessuna superficie verrà creata, ma il default di EGL_SURFACE_TYPE (finestra) escluderebbe
+    // le configurazioni della piattaforma surfaceless
+    static const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE,
+    };
+    static const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(headless->display, configAttribs, &config, 1, &configCount) ||
+        configCount == 0)
+    {
+        fprintf(stderr, "Nessuna configurazione EGL per OpenGL\n");
+        eglTerminate(headless->display);
+        return false;
+    }
+    headless->context = eglCreateContext(headless->display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (headless->context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless->context))
+    {
+        fprintf(stderr, "Impossibile creare un contesto OpenGL 4.3 core senza finestra\n");
+        headless_free(headless);
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        fprintf(stderr, "Failed to initialize GLAD\n");
+        headless_free(headless);
+        return false;
+    }
+
+    // Senza superficie non c'è un framebuffer di default: ne fa le veci questo
+    glGenRenderbuffers(1, &headless->color);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &headless->depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &headless->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "Framebuffer offscreen incompleto\n");
+        headless_free(headless);
+        return false;
+    }
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+bool headless_save_ppm(const HeadlessContext *headless, const char *path)
+{
+    size_t rowSize = (size_t)headless->width * 3;
+    unsigned char *pixels = malloc(rowSize * headless->height);
+    if (!pixels)
+    {
+        perror("Memory allocation failed");
+        return false;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, headless->framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, headless->width, headless->height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL;
+    if (ok)
+    {
+        // glReadPixels parte dalla riga in basso
+        fprintf(file, "P6\n%d %d\n255\n", headless->width, headless->height);
+        for (int y = headless->height - 1; y >= 0 && ok; y--)
+            ok = fwrite(pixels + (size_t)y * rowSize, 1, rowSize, file) == rowSize;
+        if (fclose(file) != 0)
+            ok = false;
+    }
+    if (!ok)
+        perror(path);
+    free(pixels);
+    return ok;
+}
+
+void headless_free(HeadlessContext *headless)
+{
+    if (headless->framebuffer)
+    {
+        glDeleteFramebuffers(1, &headless->framebuffer);
+        glDeleteRenderbuffers(1, &headless->color);
+        glDeleteRenderbuffers(1, &headless->depth);
+        headless->framebuffer = 0;
+    }
+    if (headless->display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (headless->context != EGL_NO_CONTEXT)
+            eglDestroyContext(headless->display, headless->context);
+        eglTerminate(headless->display);
+    }
+    headless->display = EGL_NO_DISPLAY;
+    headless->context = EGL_NO_CONTEXT;
+}
@@ -7,31 +7,39 @@
 #include "sprite.h"
 #include "game.h"
 
-int main()
+int main(int argc, char **argv)
 {
 
     // Add at the beginning of main()
    
 
-    if (!init_game()){
+    if (!init_game(argc, argv)){
         fprintf(stderr, "Failed to initialize game\n");
         return -1;
     }
 
-    double lastTime = glfwGetTime();
+    double lastTime = game_time();
     double deltaTime = 0.0;
 
 
     // Game loop
     while (game.running) {
-        double currentTime = glfwGetTime();
+        double currentTime = game_time();
         deltaTime = currentTime - lastTime;
         lastTime = currentTime;
+        // con --profile ogni fase finisce nella storia del profiler
+        profiler_begin_frame(&game.profiler);
+        profiler_cpu_begin(&game.profiler, PROFILE_UPDATE);
         update(deltaTime);
+        profiler_cpu_end(&game.profiler, PROFILE_UPDATE);
         // Il tuo codice di rendering qui
+        profiler_cpu_begin(&game.profiler, PROFILE_RENDER);
         render();
-        glfwSwapBuffers(game.window);
-        glfwPollEvents();
+        profiler_cpu_end(&game.profiler, PROFILE_RENDER);
+        profiler_cpu_begin(&game.profiler, PROFILE_PRESENT);
+        present_frame();
+        profiler_cpu_end(&game.profiler, PROFILE_PRESENT);
+        profiler_end_frame(&game.profiler);
     }
 
     cleanup();
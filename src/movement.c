@@ -0,0 +1,185 @@
+#include "movement.h"
+#include <math.h>
+#include <stdlib.h>
+
+// I rettangoli interi si toccano solo se condividono almeno un pixel
+static bool rects_overlap(int ax, int ay, int aw, int ah, int bx, int by, int bw, int bh)
+{
+    return ax < bx + bw && bx < ax + aw && ay < by + bh && by < ay + ah;
+}
+
+static bool context_collide_rect(const MoveContext *context, int x, int y, int w, int h)
+{
+    if (context->tiles && solid_grid_collide_rect(context->tiles, x, y, w, h))
+        return true;
+    for (int i = 0; i < context->solidCount; i++)
+    {
+        const Solid *solid = &context->solids[i];
+        if (solid->collidable && rects_overlap(x, y, w, h, solid->x, solid->y, solid->width, solid->height))
+            return true;
+    }
+    return false;
+}
+
+void actor_init(Actor *actor, float x, float y, int width, int height)
+{
+    actor->x = (int)roundf(x);
+    actor->y = (int)roundf(y);
+    actor->width = width;
+    actor->height = height;
+    actor->remainderX = 0.0f;
+    actor->remainderY = 0.0f;
+    actor->riding = false;
+    actor->squished = false;
+}
+
+void solid_init(Solid *solid, float x, float y, int width, int height)
+{
+    solid->x = (int)roundf(x);
+    solid->y = (int)roundf(y);
+    solid->width = width;
+    solid->height = height;
+    solid->remainderX = 0.0f;
+    solid->remainderY = 0.0f;
+    solid->collidable = true;
+}
+
+bool actor_collide_at(const MoveContext *context, const Actor *actor, int x, int y)
+{
+    return context_collide_rect(context, x, y, actor->width, actor->height);
+}
+
+// Il resto accumula le frazioni: si muove solo la parte intera arrotondata
+static int take_pixels(float *remainder, float amount)
+{
+    *remainder += amount;
+    int move = (int)roundf(*remainder);
+    *remainder -= (float)move;
+    return move;
+}
+
+bool actor_move_x(const MoveContext *context, Actor *actor, float amount)
+{
+    return actor_move_x_exact(context, actor, take_pixels(&actor->remainderX, amount));
+}
+
+bool actor_move_y(const MoveContext *context, Actor *actor, float amount)
+{
+    return actor_move_y_exact(context, actor, take_pixels(&actor->remainderY, amount));
+}
+
+bool actor_move_x_exact(const MoveContext *context, Actor *actor, int move)
+{
+    if (move == 0)
+        return true;
+
+    // Tutto il tratto libero: si salta alla fine senza passare pixel per pixel. La striscia
+    // nuova non basta se l'attore è già dentro un solido: lì il passo rifiuta il primo pixel
+    int sweptX = move > 0 ? actor->x + actor->width : actor->x + move;
+    if (!context_collide_rect(context, sweptX, actor->y, abs(move), actor->height) &&
+        !actor_collide_at(context, actor, actor->x, actor->y))
+    {
+        actor->x += move;
+        return true;
+    }
+    int sign = move > 0 ? 1 : -1;
+    while (move != 0)
+    {
+        if (actor_collide_at(context, actor, actor->x + sign, actor->y))
+            return false;
+        actor->x += sign;
+        move -= sign;
+    }
+    return true;
+}
+
+bool actor_move_y_exact(const MoveContext *context, Actor *actor, int move)
+{
+    if (move == 0)
+        return true;
+
+    int sweptY = move > 0 ? actor->y + actor->height : actor->y + move;
+    if (!context_collide_rect(context, actor->x, sweptY, actor->width, abs(move)) &&
+        !actor_collide_at(context, actor, actor->x, actor->y))
+    {
+        actor->y += move;
+        return true;
+    }
+    int sign = move > 0 ? 1 : -1;
+    while (move != 0)
+    {
+        if (actor_collide_at(context, actor, actor->x, actor->y + sign))
+            return false;
+        actor->y += sign;
+        move -= sign;
+    }
+    return true;
+}
+
+bool actor_is_riding(const Actor *actor, const Solid *solid)
+{
+    // I piedi dell'attore sono sulla riga subito sopra il solido
+    return actor->y + actor->height == solid->y && actor->x < solid->x + solid->width &&
+           solid->x < actor->x + actor->width;
+}
+
+static bool overlaps_solid(const Actor *actor, const Solid *solid)
+{
+    return rects_overlap(actor->x, actor->y, actor->width, actor->height, solid->x, solid->y, solid->width,
+                         solid->height);
+}
+
+void solid_move(const MoveContext *context, Solid *solid, float dx, float dy, Actor *const *actors, int actorCount)
+{
+    int moveX = take_pixels(&solid->remainderX, dx);
+    int moveY = take_pixels(&solid->remainderY, dy);
+    if (moveX == 0 && moveY == 0)
+        return;
+
+    // Chi cavalca si decide prima di muoversi: dopo il solido potrebbe essersene andato
+    for (int i = 0; i < actorCount; i++)
+        actors[i]->riding = actor_is_riding(actors[i], solid);
+
+    // Mentre si sposta il solido non blocca gli attori che spinge o trasporta
+    bool collidable = solid->collidable;
+    solid->collidable = false;
+    if (moveX != 0)
+    {
+        solid->x += moveX;
+        for (int i = 0; i < actorCount; i++)
+        {
+            Actor *actor = actors[i];
+            if (overlaps_solid(actor, solid))
+            {
+                // Spinto fino al bordo del solido; se non c'è spazio resta schiacciato. Spinta e
+                // trasporto sono pixel interi: il resto dell'attore non deve aggiungerne uno
+                int push = moveX > 0 ? solid->x + solid->width - actor->x : solid->x - (actor->x + actor->width);
+                if (!actor_move_x_exact(context, actor, push))
+                    actor->squished = true;
+            }
+            else if (actor->riding)
+            {
+                actor_move_x_exact(context, actor, moveX);
+            }
+        }
+    }
+    if (moveY != 0)
+    {
+        solid->y += moveY;
+        for (int i = 0; i < actorCount; i++)
+        {
+            Actor *actor = actors[i];
+            if (overlaps_solid(actor, solid))
+            {
+                int push = moveY > 0 ? solid->y + solid->height - actor->y : solid->y - (actor->y + actor->height);
+                if (!actor_move_y_exact(context, actor, push))
+                    actor->squished = true;
+            }
+            else if (actor->riding)
+            {
+                actor_move_y_exact(context, actor, moveY);
+            }
+        }
+    }
+    solid->collidable = collidable;
+}
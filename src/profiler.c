@@ -0,0 +1,202 @@
+#include "profiler.h"
+#include "clock_ms.h"
+#include <string.h>
+
+static const char *cpuZoneNames[PROFILE_CPU_ZONE_COUNT] = {
+    [PROFILE_UPDATE] = "update",
+    [PROFILE_RENDER] = "render",
+    [PROFILE_GATHER] = "gather",
+    [PROFILE_SUBMIT] = "submit",
+    [PROFILE_PRESENT] = "present",
+};
+static const char *gpuZoneNames[PROFILE_GPU_ZONE_COUNT] = {
+    [PROFILE_GPU_SETUP] = "gpu_setup",
+    [PROFILE_GPU_TILEMAP] = "gpu_tilemap",
+    [PROFILE_GPU_OPAQUE] = "gpu_opaque",
+    [PROFILE_GPU_TRANSLUCENT] = "gpu_translucent",
+    [PROFILE_GPU_BLIT] = "gpu_blit",
+};
+
+static void reset_frame(ProfileFrame *frame, uint64_t index)
+{
+    frame->frame = index;
+    frame->frameMs = -1.0;
+    for (int z = 0; z < PROFILE_CPU_ZONE_COUNT; z++)
+        frame->cpuMs[z] = -1.0;
+    for (int z = 0; z < PROFILE_GPU_ZONE_COUNT; z++)
+        frame->gpuMs[z] = -1.0;
+}
+
+// Colonne di un frame: il frame intero, poi le zone CPU, poi le zone GPU
+#define PROFILE_COLUMN_COUNT (1 + PROFILE_CPU_ZONE_COUNT + PROFILE_GPU_ZONE_COUNT)
+
+static double column_value(const ProfileFrame *frame, int column)
+{
+    if (column == 0)
+        return frame->frameMs;
+    if (column <= PROFILE_CPU_ZONE_COUNT)
+        return frame->cpuMs[column - 1];
+    return frame->gpuMs[column - 1 - PROFILE_CPU_ZONE_COUNT];
+}
+
+static const char *column_name(int column)
+{
+    if (column == 0)
+        return "frame";
+    if (column <= PROFILE_CPU_ZONE_COUNT)
+        return cpuZoneNames[column - 1];
+    return gpuZoneNames[column - 1 - PROFILE_CPU_ZONE_COUNT];
+}
+
+// Nel CSV una zona che non è stata eseguita resta vuota
+static void write_csv_value(FILE *csv, double ms)
+{
+    if (ms >= 0.0)
+        fprintf(csv, ",%.4f", ms);
+    else
+        fputc(',', csv);
+}
+
+static void record_frame(Profiler *profiler, const ProfileFrame *frame)
+{
+    profiler->history[profiler->historyHead] = *frame;
+    profiler->historyHead = (profiler->historyHead + 1) % PROFILER_HISTORY;
+    if (profiler->historyCount < PROFILER_HISTORY)
+        profiler->historyCount++;
+
+    if (!profiler->csv)
+        return;
+    fprintf(profiler->csv, "%llu", (unsigned long long)frame->frame);
+    for (int column = 0; column < PROFILE_COLUMN_COUNT; column++)
+        write_csv_value(profiler->csv, column_value(frame, column));
+    fputc('\n', profiler->csv);
+}
+
+// Completa il frame in attesa nello slot con i risultati delle sue query. Senza wait
+// un risultato non ancora pronto si scarta invece di bloccare.
+static void collect_slot(Profiler *profiler, int slot, bool wait)
+{
+    ProfileFrame *frame = &profiler->pending[slot];
+    for (int z = 0; z < PROFILE_GPU_ZONE_COUNT; z++)
+    {
+        if (!profiler->issued[slot][z])
+            continue;
+        profiler->issued[slot][z] = false;
+        GLuint available = GL_TRUE;
+        if (!wait)
+            glGetQueryObjectuiv(profiler->queries[slot][z], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(profiler->queries[slot][z], GL_QUERY_RESULT, &elapsed);
+        frame->gpuMs[z] = elapsed / 1e6;
+    }
+    record_frame(profiler, frame);
+}
+
+bool profiler_init(Profiler *profiler, const char *csvPath)
+{
+    memset(profiler, 0, sizeof(*profiler));
+    if (csvPath)
+    {
+        profiler->csv = fopen(csvPath, "w");
+        if (!profiler->csv)
+        {
+            perror(csvPath);
+            return false;
+        }
+        fprintf(profiler->csv, "frame");
+        for (int column = 0; column < PROFILE_COLUMN_COUNT; column++)
+            fprintf(profiler->csv, ",%s_ms", column_name(column));
+        fputc('\n', profiler->csv);
+    }
+    glGenQueries(PROFILER_LATENCY * PROFILE_GPU_ZONE_COUNT, &profiler->queries[0][0]);
+    profiler->enabled = true;
+    return true;
+}
+
+void profiler_begin_frame(Profiler *profiler)
+{
+    if (!profiler->enabled)
+        return;
+    // Lo slot di questo frame contiene ancora il frame di PROFILER_LATENCY frame fa
+    int slot = (int)(profiler->frame % PROFILER_LATENCY);
+    if (profiler->frame >= PROFILER_LATENCY)
+        collect_slot(profiler, slot, false);
+    reset_frame(&profiler->current, profiler->frame);
+    profiler->frameStart = clock_now_ms();
+}
+
+void profiler_end_frame(Profiler *profiler)
+{
+    if (!profiler->enabled)
+        return;
+    profiler->current.frameMs = clock_now_ms() - profiler->frameStart;
+    profiler->pending[profiler->frame % PROFILER_LATENCY] = profiler->current;
+    profiler->frame++;
+}
+
+void profiler_cpu_begin(Profiler *profiler, ProfileCpuZone zone)
+{
+    if (profiler->enabled)
+        profiler->cpuStart[zone] = clock_now_ms();
+}
+
+void profiler_cpu_end(Profiler *profiler, ProfileCpuZone zone)
+{
+    if (profiler->enabled)
+        profiler->current.cpuMs[zone] = clock_now_ms() - profiler->cpuStart[zone];
+}
+
+void profiler_gpu_begin(Profiler *profiler, ProfileGpuZone zone)
+{
+    if (!profiler || !profiler->enabled)
+        return;
+    glBeginQuery(GL_TIME_ELAPSED, profiler->queries[profiler->frame % PROFILER_LATENCY][zone]);
+}
+
+void profiler_gpu_end(Profiler *profiler, ProfileGpuZone zone)
+{
+    if (!profiler || !profiler->enabled)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    profiler->issued[profiler->frame % PROFILER_LATENCY][zone] = true;
+}
+
+void profiler_print_summary(const Profiler *profiler)
+{
+    if (profiler->historyCount == 0)
+        return;
+    printf("Profilo degli ultimi %d frame (media, massimo):\n", profiler->historyCount);
+    for (int column = 0; column < PROFILE_COLUMN_COUNT; column++)
+    {
+        double sum = 0.0, max = 0.0;
+        int count = 0;
+        for (int i = 0; i < profiler->historyCount; i++)
+        {
+            double ms = column_value(&profiler->history[i], column);
+            if (ms < 0.0)
+                continue;
+            sum += ms;
+            max = ms > max ? ms : max;
+            count++;
+        }
+        if (count > 0)
+            printf("  %-16s %8.3f ms  max %8.3f ms\n", column_name(column), sum / count, max);
+    }
+}
+
+void profiler_free(Profiler *profiler)
+{
+    if (!profiler->enabled)
+        return;
+    // I frame ancora in attesa, dal più vecchio: qui si può aspettare la GPU
+    uint64_t first = profiler->frame > PROFILER_LATENCY ? profiler->frame - PROFILER_LATENCY : 0;
+    for (uint64_t f = first; f < profiler->frame; f++)
+        collect_slot(profiler, (int)(f % PROFILER_LATENCY), true);
+    glDeleteQueries(PROFILER_LATENCY * PROFILE_GPU_ZONE_COUNT, &profiler->queries[0][0]);
+    if (profiler->csv)
+        fclose(profiler->csv);
+    profiler->csv = NULL;
+    profiler->enabled = false;
+}
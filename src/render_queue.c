@@ -0,0 +1,127 @@
+#include "render_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Float bits reordered so that unsigned comparison matches float comparison
+static uint32_t float_sort_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+uint64_t render_sort_key(const Sprite *sprite, RenderPass pass, RenderLayer layer)
+{
+    // Con la proiezione ortho(-1, 1) uno zIndex maggiore è più vicino alla camera:
+    // crescente = dal fondo verso la camera; per gli opachi si invertono layer e profondità
+    uint32_t depth = float_sort_bits(sprite->zIndex);
+    uint32_t sortLayer = (uint32_t)layer & 0x3F;
+    if (pass == RENDER_PASS_OPAQUE)
+    {
+        depth = ~depth;
+        sortLayer = 0x3F - sortLayer;
+    }
+    return (uint64_t)pass << RENDER_KEY_PASS_SHIFT |
+           (uint64_t)sortLayer << RENDER_KEY_LAYER_SHIFT |
+           (uint64_t)depth << RENDER_KEY_DEPTH_SHIFT |
+           (uint64_t)sprite_variant(sprite) << RENDER_KEY_VARIANT_SHIFT |
+           (uint64_t)((uint16_t)sprite->layerIndex);
+}
+
+int render_queue_init(RenderQueue *queue, size_t capacity)
+{
+    queue->keys = malloc(capacity * sizeof(uint64_t));
+    queue->items = malloc(capacity * sizeof(uint32_t));
+    queue->scratchKeys = malloc(capacity * sizeof(uint64_t));
+    queue->scratchItems = malloc(capacity * sizeof(uint32_t));
+    queue->count = 0;
+    queue->capacity = capacity;
+    if (!queue->keys || !queue->items || !queue->scratchKeys || !queue->scratchItems)
+    {
+        perror("Memory allocation failed");
+        render_queue_free(queue);
+        return 0;
+    }
+    return 1;
+}
+
+void render_queue_free(RenderQueue *queue)
+{
+    free(queue->keys);
+    free(queue->items);
+    free(queue->scratchKeys);
+    free(queue->scratchItems);
+    memset(queue, 0, sizeof(*queue));
+}
+
+void render_queue_clear(RenderQueue *queue)
+{
+    queue->count = 0;
+}
+
+int render_queue_push(RenderQueue *queue, uint64_t key, uint32_t item)
+{
+    if (queue->count == queue->capacity)
+        return 0;
+    queue->keys[queue->count] = key;
+    queue->items[queue->count] = item;
+    queue->count++;
+    return 1;
+}
+
+void render_queue_sort(RenderQueue *queue)
+{
+    size_t n = queue->count;
+    if (n < 2)
+        return;
+
+    // Un istogramma per byte in una sola lettura delle chiavi
+    size_t histogram[8][256];
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t key = queue->keys[i];
+        for (int b = 0; b < 8; b++)
+        {
+            histogram[b][(key >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    uint64_t *keys = queue->keys, *outKeys = queue->scratchKeys;
+    uint32_t *items = queue->items, *outItems = queue->scratchItems;
+    for (int b = 0; b < 8; b++)
+    {
+        int shift = b * 8;
+        // Tutte le chiavi hanno lo stesso byte: il passo non cambierebbe l'ordine
+        if (histogram[b][(keys[0] >> shift) & 0xFF] == n)
+            continue;
+
+        size_t offsets[256];
+        size_t sum = 0;
+        for (int d = 0; d < 256; d++)
+        {
+            offsets[d] = sum;
+            sum += histogram[b][d];
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t slot = offsets[(keys[i] >> shift) & 0xFF]++;
+            outKeys[slot] = keys[i];
+            outItems[slot] = items[i];
+        }
+
+        uint64_t *tk = keys;
+        keys = outKeys;
+        outKeys = tk;
+        uint32_t *ti = items;
+        items = outItems;
+        outItems = ti;
+    }
+
+    // Il risultato deve stare in keys/items: si scambiano i buffer invece di copiare
+    queue->scratchKeys = outKeys;
+    queue->scratchItems = outItems;
+    queue->keys = keys;
+    queue->items = items;
+}
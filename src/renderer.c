@@ -2,13 +2,48 @@
 
 #include "renderer.h"
 #include "game.h"
+#include "shader_cache.h"
 #include <stdio.h> //for error messages
 #include <stdlib.h>
 #include <string.h> // For strdup
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <math.h>
 
-GLint cameraPosLoc;
+// Indici delle decorazioni visibili prodotti dal culling su CPU
+uint32_t visibleDecorations[MAX_STATIC_OBJECTS];
+
+// Uniform di sprite.vert, una copia per programma (RenderPass x SpriteVariant)
+GLint cameraPosLoc[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+GLint instanceOffsetLoc[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+GLint useVisibleListLoc[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+GLint visibleBaseLoc[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+GLint parallaxTableLoc[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+GLint layerMapLoc[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+
+// Uniform del compute shader di culling
+GLint cullCameraPosLoc;
+GLint cullViewSizeLoc;
+GLint cullInstanceOffsetLoc;
+GLint cullSpriteCountLoc;
+GLint cullVisibleBaseLoc;
+GLint cullCommandIndexLoc;
+GLint cullParallaxTableLoc;
+
+// Uniform di tilemap.vert / tilemap.frag
+GLint tileCameraPosLoc;
+GLint tileChunkRectsLoc;
+GLint tileZIndexLoc;
+GLint tileLayerLoc;
+GLint tileColumnsLoc;
+
+#define CULL_GROUP_SIZE 64 // local_size_x di sprite_cull.comp
+
+// Layout fissato da glDrawArraysIndirect
+typedef struct {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+} DrawArraysIndirectCommand;
 
 // Helper function to read the entire contents of a file into a string
 char *read_file_to_string(const char *filename)
@@ -47,55 +82,278 @@ char *read_file_to_string(const char *filename)
     return buffer;
 }
 
-// --- (Your shader compilation functions from the previous example) ---
-GLuint compile_shader(GLenum type, const char *source);
-GLuint create_program(GLuint vertexShader, GLuint fragmentShader);
+// Reads a shader and expands it for the current renderer configuration:
+// 'defines' goes right after the #version line and every  #include "file"  line is
+// replaced by shaders/file (one level, enough for sprite_data.glsl)
+char *load_shader_source(const char *filename, const char *defines)
+{
+    char *source = read_file_to_string(filename);
+    if (!source)
+        return NULL;
+
+    // Directory del file, per risolvere gli include
+    char directory[256] = "";
+    const char *slash = strrchr(filename, '/');
+    if (slash)
+    {
+        size_t len = (size_t)(slash - filename) + 1;
+        if (len >= sizeof(directory))
+            len = sizeof(directory) - 1;
+        memcpy(directory, filename, len);
+        directory[len] = '\0';
+    }
+
+    size_t capacity = strlen(source) + strlen(defines) + 2;
+    char *expanded = malloc(capacity);
+    if (!expanded)
+    {
+        free(source);
+        return NULL;
+    }
+    size_t length = 0;
+    int versionSeen = 0;
+
+    char *line = source;
+    while (*line)
+    {
+        char *end = strchr(line, '\n');
+        size_t lineLength = end ? (size_t)(end - line) + 1 : strlen(line);
+
+        const char *chunk = line;
+        size_t chunkLength = lineLength;
+        char *included = NULL;
+        const char *extra = NULL;
+
+        if (strncmp(line, "#include \"", 10) == 0)
+        {
+            char path[512];
+            const char *nameStart = line + 10;
+            const char *nameEnd = strchr(nameStart, '"');
+            if (nameEnd && (!end || nameEnd < end))
+            {
+                snprintf(path, sizeof(path), "%s%.*s", directory, (int)(nameEnd - nameStart), nameStart);
+                included = read_file_to_string(path);
+            }
+            if (!included)
+            {
+                fprintf(stderr, "Include non valido in %s: %.*s\n", filename, (int)lineLength, line);
+                free(source);
+                free(expanded);
+                return NULL;
+            }
+            chunk = included;
+            chunkLength = strlen(included);
+            extra = "\n";
+        }
+        else if (!versionSeen && strncmp(line, "#version", 8) == 0)
+        {
+            versionSeen = 1;
+            extra = defines;
+        }
+
+        size_t extraLength = extra ? strlen(extra) : 0;
+        if (length + chunkLength + extraLength + 2 > capacity)
+        {
+            capacity = (length + chunkLength + extraLength + 2) * 2;
+            char *grown = realloc(expanded, capacity);
+            if (!grown)
+            {
+                free(included);
+                free(source);
+                free(expanded);
+                return NULL;
+            }
+            expanded = grown;
+        }
+        memcpy(expanded + length, chunk, chunkLength);
+        length += chunkLength;
+        if (extra)
+        {
+            if (chunkLength && expanded[length - 1] != '\n')
+                expanded[length++] = '\n';
+            memcpy(expanded + length, extra, extraLength);
+            length += extraLength;
+        }
+        free(included);
+        line += lineLength;
+    }
+    expanded[length] = '\0';
+    free(source);
+    return expanded;
+}
 
-// --- (Your shader compilation functions - MODIFIED to take char* instead of #include) ---
-GLuint compile_shader(GLenum type, const char *source)
+// Compilazione in due tempi: shader_build_begin accoda compilazione e link senza
+// leggerne lo stato, shader_build_finish lo controlla. Con KHR_parallel_shader_compile
+// il driver lavora sui suoi thread e shader_build_ready dice quando finish non blocca.
+static void shader_build_begin(ShaderBuild *build, const char *vertexPath, const char *fragmentPath, const char *defines)
 {
-    // ... (Exactly as before, but using the 'source' parameter) ...
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+    memset(build, 0, sizeof(*build));
+    // Con fragmentPath NULL vertexPath è un compute shader
+    const char *paths[2] = {vertexPath, fragmentPath};
+    const GLenum types[2] = {fragmentPath ? GL_VERTEX_SHADER : GL_COMPUTE_SHADER, GL_FRAGMENT_SHADER};
+    int count = fragmentPath ? 2 : 1;
 
-    // Check for compile errors
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    char *sources[2] = {NULL, NULL};
+    for (int i = 0; i < count; i++)
     {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        fprintf(stderr, "Shader compilation failed:\n%s\n", infoLog);
-        // Don't exit here; return 0 to indicate failure
-        return 0;
+        sources[i] = load_shader_source(paths[i], defines);
+        if (!sources[i])
+        {
+            // Error messages are already printed by read_file_to_string
+            free(sources[0]);
+            build->failed = true;
+            return;
+        }
     }
-    return shader;
+
+    // Se la cache ha il binario per gli stessi sorgenti (già espansi) si salta la compilazione
+    build->key = shader_cache_key((const char *const *)sources, count);
+    build->program = shader_cache_load(build->key);
+    if (!build->program)
+    {
+        build->program = glCreateProgram();
+        for (int i = 0; i < count; i++)
+        {
+            GLuint shader = glCreateShader(types[i]);
+            glShaderSource(shader, 1, (const char *const *)&sources[i], NULL);
+            glCompileShader(shader);
+            glAttachShader(build->program, shader);
+            build->shaders[build->shaderCount++] = shader;
+        }
+        glProgramParameteri(build->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); // per shader_cache_store
+        glLinkProgram(build->program);
+    }
+    for (int i = 0; i < count; i++)
+        free(sources[i]);
 }
 
-GLuint create_program(GLuint vertexShader, GLuint fragmentShader)
+static bool shader_build_ready(const ShaderBuild *build)
 {
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+    if (build->shaderCount == 0 || !GLAD_GL_KHR_parallel_shader_compile)
+        return true; // senza l'estensione finish aspetta il driver
+    GLint done = GL_FALSE;
+    glGetProgramiv(build->program, GL_COMPLETION_STATUS_KHR, &done);
+    return done;
+}
+
+// Il programma linkato (salvato nella cache), 0 in caso di errore
+static GLuint shader_build_finish(ShaderBuild *build)
+{
+    if (build->failed)
+        return 0;
+    GLuint program = build->program;
+    if (build->shaderCount == 0)
+        return program; // dalla cache
 
-    // Check for linking errors
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success)
     {
         char infoLog[512];
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        fprintf(stderr, "Shader program linking failed:\n%s\n", infoLog);
-        exit(EXIT_FAILURE); // Or handle the error more gracefully
+        bool compileError = false;
+        for (int i = 0; i < build->shaderCount; i++)
+        {
+            glGetShaderiv(build->shaders[i], GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(build->shaders[i], sizeof(infoLog), NULL, infoLog);
+                fprintf(stderr, "Shader compilation failed:\n%s\n", infoLog);
+                compileError = true;
+            }
+        }
+        if (!compileError)
+        {
+            glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+            fprintf(stderr, "Shader program linking failed:\n%s\n", infoLog);
+        }
+        glDeleteProgram(program);
+        program = 0;
+    }
+    else
+    {
+        shader_cache_store(program, build->key);
+    }
+
+    // Clean up individual shaders (they are linked in the program)
+    for (int i = 0; i < build->shaderCount; i++)
+    {
+        if (program)
+            glDetachShader(program, build->shaders[i]);
+        glDeleteShader(build->shaders[i]);
     }
+    build->shaderCount = 0;
+    build->program = 0;
     return program;
 }
 
+// Compila e linka vertex + fragment shader con i #define dati; 0 in caso di errore.
+GLuint load_program(const char *vertexPath, const char *fragmentPath, const char *defines)
+{
+    ShaderBuild build;
+    shader_build_begin(&build, vertexPath, fragmentPath, defines);
+    return shader_build_finish(&build);
+}
+
+GLuint load_compute_program(const char *filename, const char *defines)
+{
+    ShaderBuild build;
+    shader_build_begin(&build, filename, NULL, defines);
+    return shader_build_finish(&build);
+}
+
+// Una permutazione di sprite.vert per ogni SpriteVariant, e di sprite.frag per ogni passata
+static const char *variantDefines[SPRITE_VARIANT_COUNT] = {
+    [SPRITE_VARIANT_NO_PARALLAX] = "#define VARIANT_NO_PARALLAX\n",
+    [SPRITE_VARIANT_AXIS_ALIGNED] = "",
+    [SPRITE_VARIANT_ROTATED] = "#define VARIANT_ROTATED\n",
+};
+static const char *passDefines[RENDER_PASS_COUNT] = {
+    [RENDER_PASS_OPAQUE] = "",
+    [RENDER_PASS_TRANSLUCENT] = "#define TRANSLUCENT_PASS\n",
+};
+
+static void begin_sprite_builds(Renderer *renderer)
+{
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            char defines[sizeof(renderer->shaderDefines) + 64];
+            snprintf(defines, sizeof(defines), "%s%s%s", renderer->shaderDefines, passDefines[p], variantDefines[v]);
+            shader_build_begin(&renderer->spriteBuilds[p][v], "shaders/sprite.vert", "shaders/sprite.frag", defines);
+        }
+    }
+}
+
+static void setup_sprite_program(Renderer *renderer, int p, int v)
+{
+    GLuint program = renderer->shaderPrograms[p][v];
+    glUseProgram(program); // Use the program to set uniforms
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, (const GLfloat *)renderer->projection);
+    cameraPosLoc[p][v] = glGetUniformLocation(program, "cameraPos");
+    instanceOffsetLoc[p][v] = glGetUniformLocation(program, "instanceOffset");
+    useVisibleListLoc[p][v] = glGetUniformLocation(program, "useVisibleList");
+    visibleBaseLoc[p][v] = glGetUniformLocation(program, "visibleBase");
+    parallaxTableLoc[p][v] = glGetUniformLocation(program, "parallaxTable");
+    layerMapLoc[p][v] = glGetUniformLocation(program, "layerMap");
+    glUseProgram(0); // Unbind
+}
+
 // --- (Your init_quad function, adapted) ---
 void init_quad(Renderer *renderer)
 {
+    glGenVertexArrays(1, &renderer->quadVAO);
+    if (renderer->flags & RENDERER_VERTEX_PULLING)
+    {
+        // Vertex pulling: sprite.vert ricava gli angoli da gl_VertexID, il VAO resta vuoto
+        // (il core profile ne richiede comunque uno legato per disegnare)
+        renderer->quadMode = GL_TRIANGLE_STRIP;
+        renderer->quadVertexCount = 4;
+        return;
+    }
+    renderer->quadMode = GL_TRIANGLES;
+    renderer->quadVertexCount = 6;
+
     // ... (Code from previous example, but use renderer->quadVAO) ...
     const float quadVertices[] = {
         // Positions   // Texture Coords
@@ -106,7 +364,6 @@ void init_quad(Renderer *renderer)
         0.5f, -0.5f, 1.0f, 0.0f,
         0.5f, 0.5f, 1.0f, 1.0f,
         -0.5f, 0.5f, 0.0f, 1.0f};
-    glGenVertexArrays(1, &renderer->quadVAO);
     GLuint quadVBO;
     glGenBuffers(1, &quadVBO);
 
@@ -126,197 +383,1198 @@ void init_quad(Renderer *renderer)
     glDeleteBuffers(1, &quadVBO);
 }
 
-void init_instance_buffer(Renderer *renderer)
+int init_instance_buffer(Renderer *renderer)
 {
-    // ... (Code from previous example, but use renderer->instanceSSBO and renderer->maxSprites) ...
+    // Ring buffer persistente: RENDERER_FRAMES_IN_FLIGHT regioni da maxSprites sprite ciascuna.
+    // Il gather scrive direttamente nella regione del frame corrente, le fence evitano
+    // di sovrascrivere una regione che la GPU sta ancora leggendo.
+    if (!GLAD_GL_ARB_buffer_storage)
+    {
+        fprintf(stderr, "GL_ARB_buffer_storage non supportato: impossibile creare il ring buffer delle istanze\n");
+        return 0;
+    }
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr ringSize = (GLsizeiptr)(RENDERER_FRAMES_IN_FLIGHT * renderer->maxSprites * renderer->instanceStride);
+
     glGenBuffers(1, &renderer->instanceSSBO);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->instanceSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, renderer->maxSprites * sizeof(Sprite), NULL, GL_DYNAMIC_DRAW); // Allocate enough space
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, renderer->instanceSSBO);                                // Bind to binding point 0
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, ringSize, NULL, flags);
+    renderer->instanceRing = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, ringSize, flags);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, renderer->instanceSSBO); // Bind to binding point 0
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-}
 
-void update_instance_buffer(Renderer *renderer, Sprite *sprites, size_t numSprites)
-{
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->instanceSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, renderer->maxSprites * sizeof(Sprite), NULL, GL_DYNAMIC_DRAW);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, numSprites * sizeof(Sprite), sprites);
+    if (!renderer->instanceRing)
+    {
+        fprintf(stderr, "OpenGL error in init_instance_buffer: 0x%04X\n", glGetError());
+        return 0;
+    }
 
-    // Check for errors
-    GLenum err = glGetError();
-    if (err != GL_NO_ERROR)
+    for (int i = 0; i < RENDERER_FRAMES_IN_FLIGHT; i++)
     {
-        fprintf(stderr, "pointer: %p num %d in %d\n", sprites, numSprites, renderer->instanceSSBO);
-        fprintf(stderr, "OpenGL error in update_instance_buffer: 0x%04X\n", err);
+        renderer->frameFences[i] = NULL;
     }
+    renderer->frameRegion = 0;
 
+    // Regione statica: decorazioni caricate al load del livello e aggiornate solo quando cambiano
+    glGenBuffers(1, &renderer->staticSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->staticSSBO);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, MAX_STATIC_OBJECTS * renderer->instanceStride, NULL, GL_DYNAMIC_STORAGE_BIT);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    renderer->staticCount = 0;
+
+    // Il gather scrive Sprite in staging con la chiave di ordinamento nella render queue; il draw
+    // li copia (e impacchetta) nella regione del ring in ordine di chiave. Le decorazioni hanno una
+    // copia CPU del buffer statico con lo slot di ciascuna, così un aggiornamento che non cambia
+    // la chiave non rifà l'ordinamento.
+    renderer->staging = malloc(renderer->maxSprites * sizeof(Sprite));
+    renderer->runs = malloc(renderer->maxSprites * sizeof(RenderRun));
+    renderer->staticMirror = malloc(MAX_STATIC_OBJECTS * renderer->instanceStride);
+    renderer->staticSlot = malloc(MAX_STATIC_OBJECTS * sizeof(uint32_t));
+    renderer->staticKey = malloc(MAX_STATIC_OBJECTS * sizeof(uint64_t));
+    renderer->staticRuns = malloc(MAX_STATIC_OBJECTS * sizeof(RenderRun));
+    if (!renderer->staging || !renderer->runs || !renderer->staticMirror || !renderer->staticSlot ||
+        !renderer->staticKey || !renderer->staticRuns)
+    {
+        perror("Memory allocation failed");
+        return 0;
+    }
+    renderer->staticRunCount = 0;
+    if (!render_queue_init(&renderer->queue, renderer->maxSprites) ||
+        !render_queue_init(&renderer->staticQueue, MAX_STATIC_OBJECTS))
+    {
+        return 0;
+    }
+    return 1;
 }
 
-int renderer_init(Renderer *renderer, size_t maxSprites, int screenWidth, int screenHeight)
+// Uniform di un programma di culling appena linkato (all'avvio o dopo una ricarica)
+static void setup_cull_program(Renderer *renderer)
 {
-    renderer->maxSprites = maxSprites;
+    cullCameraPosLoc = glGetUniformLocation(renderer->cullProgram, "cameraPos");
+    cullViewSizeLoc = glGetUniformLocation(renderer->cullProgram, "viewSize");
+    cullInstanceOffsetLoc = glGetUniformLocation(renderer->cullProgram, "instanceOffset");
+    cullSpriteCountLoc = glGetUniformLocation(renderer->cullProgram, "spriteCount");
+    cullVisibleBaseLoc = glGetUniformLocation(renderer->cullProgram, "visibleBase");
+    cullCommandIndexLoc = glGetUniformLocation(renderer->cullProgram, "commandIndex");
+    cullParallaxTableLoc = glGetUniformLocation(renderer->cullProgram, "parallaxTable");
+}
 
-    // Initialize quad and instance buffer
-    init_quad(renderer);
-    init_instance_buffer(renderer);
+int init_culling(Renderer *renderer)
+{
+    renderer->cullProgram = load_compute_program("shaders/sprite_cull.comp", renderer->shaderDefines);
+    if (!renderer->cullProgram)
+        return 0;
+    setup_cull_program(renderer);
 
-    // --- Load shaders at runtime ---
-    char *vertexShaderSource = read_file_to_string("shaders/sprite.vert");
-    char *fragmentShaderSource = read_file_to_string("shaders/sprite.frag");
+    // Un indice visibile (e al più un comando indiretto) per ogni sprite statico e per ogni
+    // sprite di una regione del ring
+    glGenBuffers(1, &renderer->visibleSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->visibleSSBO);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, (MAX_STATIC_OBJECTS + renderer->maxSprites) * sizeof(GLuint), NULL, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, renderer->visibleSSBO);
 
-    if (!vertexShaderSource || !fragmentShaderSource)
-    {
-        // Error messages are already printed by read_file_to_string
-        if (vertexShaderSource)
-            free(vertexShaderSource);
-        if (fragmentShaderSource)
-            free(fragmentShaderSource);
-        return 0; // Indicate failure
-    }
+    glGenBuffers(1, &renderer->drawCommandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->drawCommandBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, (MAX_STATIC_OBJECTS + renderer->maxSprites) * sizeof(DrawArraysIndirectCommand), NULL, GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, renderer->drawCommandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return 1;
+}
 
-    GLuint vertexShader = compile_shader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compile_shader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+static void setup_tile_program(Renderer *renderer)
+{
+    GLuint program = renderer->tileProgram;
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, (const GLfloat *)renderer->projection);
+    glUniform1f(glGetUniformLocation(program, "tileSize"), TILEMAP_TILE_SIZE);
+    glUniform1i(glGetUniformLocation(program, "textureArray"), 0);
+    glUniform1i(glGetUniformLocation(program, "tileIndices"), 1);
+    tileCameraPosLoc = glGetUniformLocation(program, "cameraPos");
+    tileChunkRectsLoc = glGetUniformLocation(program, "chunkRects");
+    tileZIndexLoc = glGetUniformLocation(program, "zIndex");
+    tileLayerLoc = glGetUniformLocation(program, "tilesetLayer");
+    tileColumnsLoc = glGetUniformLocation(program, "tilesetColumns");
+    glUseProgram(0);
+}
 
-    free(vertexShaderSource); // Free the shader source strings!
-    free(fragmentShaderSource);
+int init_tilemap(Renderer *renderer)
+{
+    renderer->tileProgram = load_program("shaders/tilemap.vert", "shaders/tilemap.frag", renderer->shaderDefines);
+    if (!renderer->tileProgram)
+        return 0;
+    setup_tile_program(renderer);
 
-    if (!vertexShader || !fragmentShader)
-    {
-        // Don't leak shaders if compilation failed
-        if (vertexShader)
-            glDeleteShader(vertexShader);
-        if (fragmentShader)
-            glDeleteShader(fragmentShader);
-        return 0; // Indicate failure
-    }
+    glGenVertexArrays(1, &renderer->tileVAO);
+    renderer->tileIndexTexture = 0; // creata al primo renderer_sync_tilemap
+    renderer->tileIndexWidth = 0;
+    renderer->tileIndexHeight = 0;
+    return 1;
+}
+
+// Wait until the GPU has finished reading the given ring region
+void wait_instance_region(Renderer *renderer, size_t region)
+{
+    GLsync fence = renderer->frameFences[region];
+    if (!fence)
+        return;
 
-    renderer->shaderProgram = create_program(vertexShader, fragmentShader);
-    if (!renderer->shaderProgram)
+    GLbitfield waitFlags = 0;
+    GLuint64 timeout = 0;
+    for (;;)
     {
-        return 0;
+        GLenum result = glClientWaitSync(fence, waitFlags, timeout);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            break;
+        if (result == GL_WAIT_FAILED)
+        {
+            fprintf(stderr, "OpenGL error in wait_instance_region: 0x%04X\n", glGetError());
+            break;
+        }
+        // GL_TIMEOUT_EXPIRED: flush the command queue and block for real
+        waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        timeout = 1000000000; // 1 s
     }
+    glDeleteSync(fence);
+    renderer->frameFences[region] = NULL;
+}
 
-    // Set up projection matrix (once, since it doesn't change)
-    // zoom = 2
-    mat4x4_ortho(renderer->projection, 0.0f, (float)screenWidth / 2, (float)screenHeight / 2, 0.0f, -1.0f, 1.0f);
+static bool layer_is_atlas_page(const Renderer *renderer, int layer)
+{
+    return (uint32_t)layer < renderer->atlas.layerCount;
+}
 
-    glUseProgram(renderer->shaderProgram); // Use the program to set uniforms
-    glUniformMatrix4fv(glGetUniformLocation(renderer->shaderProgram, "projection"), 1, GL_FALSE, (const GLfloat *)renderer->projection);
-    cameraPosLoc = glGetUniformLocation(renderer->shaderProgram, "cameraPos");
-    glUseProgram(0); // Unbind
+// Texture array degli sprite: i layer sono già decodificati (o in decodifica) dal loader,
+// qui restano solo le upload, che richiedono il contesto GL.
+static int init_texture_array(Renderer *renderer, TextureLoader *loader)
+{
+    texture_loader_wait(loader);
+    double uploadStart = clock_now_ms();
+    int width = loader->width;
+    int height = loader->height;
+    // Catena di mip decisa dal loader (corta per le pagine dell'atlas), letta dalla cache
+    // o calcolata dopo la decodifica
+    int mipLevels = loader->mipLevels;
 
-    // Clean up individual shaders (they are linked in the program)
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Slot della texture array: tutti i layer più quelli di scorta, entro il budget di VRAM.
+    // I layer che non ci stanno si caricano quando un frame li usa (vedi update_residency).
+    int budgetSlots = (int)((size_t)RENDERER_TEXTURE_BUDGET_MB * 1024 * 1024 / texture_cache_chain_size(width, height, mipLevels));
+    int layers = loader->layerCount + RENDERER_STREAMED_LAYERS; // Numero di texture nell'array
+    if (layers > budgetSlots)
+        layers = budgetSlots > 0 ? budgetSlots : 1;
+    if (layers > RENDERER_MAX_TEXTURE_LAYERS)
+        layers = RENDERER_MAX_TEXTURE_LAYERS;
+    renderer->textureLayerCount = layers;
+    texture_residency_init(&renderer->residency, layers);
 
     // Creazione della texture array
-    GLuint textureArrayID;
-    glGenTextures(1, &textureArrayID);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArrayID);
-
-    // Supponiamo di avere N texture tutte di dimensione width x height
-    int width = 512;
-    int height = 512;
-    int layers = 4;    // Numero di texture nell'array
-    int mipLevels = 1; // Se non vuoi usare mipmapping, altrimenti calcola il valore appropriato
+    glGenTextures(1, &renderer->textureArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, renderer->textureArray);
     // Allocazione dello spazio per la texture array
     glTexStorage3D(GL_TEXTURE_2D_ARRAY,
                    mipLevels,              // Numero di livelli mipmap
                    GL_RGBA8,               // Formato interno
                    width, height, layers); // Dimensioni e numero di layer
 
-    // Caricamento di ogni texture nel suo strato
-    for (int i = 0; i < layers; i++)
+    // Caricamento di ogni texture nel suo strato. I layer che non si caricano restano
+    // traslucidi: il contenuto non inizializzato non deve scrivere la profondità.
+    // Le pagine dell'atlas hanno sempre padding e spazio libero trasparenti: la passata
+    // la decidono le regioni (sprite_pass), il layer conta solo se manca.
+    memset(renderer->layerTranslucent, 1, sizeof(renderer->layerTranslucent));
+    renderer->atlas = loader->atlas;
+    memset(&loader->atlas, 0, sizeof(loader->atlas));
+    for (int i = 0; i < loader->layerCount; i++)
     {
-        char filename[256];
-        sprintf(filename, "./assets/textures/%d.png", i);
-
-        int imgWidth, imgHeight, imgChannels;
-        unsigned char *imageData = stbi_load(filename, &imgWidth, &imgHeight, &imgChannels, STBI_rgb_alpha);
-
-        if (imageData)
+        texture_residency_set_path(&renderer->residency, i, loader->layers[i].path);
+    }
+    for (int i = 0; i < loader->layerCount && i < layers; i++)
+    {
+        const TextureLayer *layer = &loader->layers[i];
+        int slot = texture_residency_acquire(&renderer->residency, i, 0); // all'inizio slot == layer
+        bool ok = false;
+        if (layer->pixels)
         {
             // Verifica che le dimensioni corrispondano a quelle della texture array
-            if (imgWidth == width && imgHeight == height)
+            if (layer->width == width && layer->height == height && layer->mipLevels == mipLevels)
             {
-                glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
-                                0,                // Livello mipmap
-                                0, 0, i,          // xOffset, yOffset, zOffset (layer)
-                                width, height, 1, // width, height, depth (numero di layer da caricare)
-                                GL_RGBA,          // Formato dei dati
-                                GL_UNSIGNED_BYTE, // Tipo dei dati
-                                imageData);       // Puntatore ai dati
+                ok = true;
+                renderer->layerTranslucent[i] = layer->translucent && !layer_is_atlas_page(renderer, i);
+                const unsigned char *levelPixels = layer->pixels;
+                int levelWidth = width, levelHeight = height;
+                for (int level = 0; level < mipLevels; level++)
+                {
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                                    level,                       // Livello mipmap
+                                    0, 0, slot,                  // xOffset, yOffset, zOffset (layer)
+                                    levelWidth, levelHeight, 1,  // width, height, depth (numero di layer da caricare)
+                                    GL_RGBA,                     // Formato dei dati
+                                    GL_UNSIGNED_BYTE,            // Tipo dei dati
+                                    levelPixels);                // Puntatore ai dati
+                    levelPixels += (size_t)levelWidth * levelHeight * 4;
+                    levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+                    levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+                }
             }
             else
             {
                 printf("Texture %d ha dimensioni diverse (%dx%d invece di %dx%d)\n",
-                       i, imgWidth, imgHeight, width, height);
+                       i, layer->width, layer->height, width, height);
                 // Qui potresti ridimensionare l'immagine se necessario
             }
-
-            // Libera la memoria dell'immagine dopo averla caricata nella texture
-            stbi_image_free(imageData);
         }
         else
         {
-            printf("Impossibile caricare la texture %s\n", filename);
+            printf("Impossibile caricare la texture %s\n", layer->path);
         }
+        texture_residency_loaded(&renderer->residency, slot, ok);
     }
 
-    // Impostazione dei parametri di texture senza mipmap
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Pixel art: un texel per pixel di gioco, senza filtraggio; la catena (se c'è) serve solo
+    // agli sprite rimpiccioliti, e anche lì si prende il livello più vicino
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, mipLevels > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    // Generazione delle mipmap (opzionale)
-    // glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    // Il renderer si è tenuto il manifest; i pixel non servono più
+    texture_loader_free(loader);
+    loader->uploadMs = clock_now_ms() - uploadStart;
+
+    // Senza streaming il gioco funziona lo stesso, solo senza caricamenti a runtime
+    if (!texture_stream_init(&renderer->textureStream, renderer->textureArray, width, height, mipLevels, layers))
+    {
+        fprintf(stderr, "Streaming delle texture non disponibile\n");
+    }
+    return 1;
+}
+
+// Render target a risoluzione di gioco. Nella finestra finisce ingrandito del massimo
+// fattore intero che ci sta, centrato; con uno schermo più piccolo del gioco si riduce.
+static int init_scene_target(Renderer *renderer, int screenWidth, int screenHeight)
+{
+    renderer->screenWidth = screenWidth;
+    renderer->screenHeight = screenHeight;
+    GLint window;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &window);
+    renderer->windowFBO = (GLuint)window;
+    int scale = screenWidth / RENDERER_GAME_WIDTH < screenHeight / RENDERER_GAME_HEIGHT ? screenWidth / RENDERER_GAME_WIDTH
+                                                                                         : screenHeight / RENDERER_GAME_HEIGHT;
+    int width = RENDERER_GAME_WIDTH * scale, height = RENDERER_GAME_HEIGHT * scale;
+    if (scale == 0)
+    {
+        width = screenWidth;
+        height = screenWidth * RENDERER_GAME_HEIGHT / RENDERER_GAME_WIDTH;
+        if (height > screenHeight)
+        {
+            height = screenHeight;
+            width = screenHeight * RENDERER_GAME_WIDTH / RENDERER_GAME_HEIGHT;
+        }
+    }
+    renderer->sceneRect[0] = (screenWidth - width) / 2;
+    renderer->sceneRect[1] = (screenHeight - height) / 2;
+    renderer->sceneRect[2] = renderer->sceneRect[0] + width;
+    renderer->sceneRect[3] = renderer->sceneRect[1] + height;
+
+    glGenRenderbuffers(1, &renderer->sceneColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderer->sceneColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, RENDERER_GAME_WIDTH, RENDERER_GAME_HEIGHT);
+    glGenRenderbuffers(1, &renderer->sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderer->sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, RENDERER_GAME_WIDTH, RENDERER_GAME_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &renderer->sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer->sceneFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderer->sceneColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderer->sceneDepth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer->windowFBO);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "Framebuffer della scena incompleto: 0x%x\n", status);
+        return 0;
+    }
+    return 1;
+}
+
+int renderer_init(Renderer *renderer, size_t maxSprites, int screenWidth, int screenHeight, unsigned flags, TextureLoader *textures)
+{
+    renderer->maxSprites = maxSprites;
+    renderer->flags = flags;
+    renderer->instanceStride = (flags & RENDERER_PACKED_INSTANCES) ? sizeof(PackedSprite) : sizeof(Sprite);
+    memset(&renderer->parallax, 0, sizeof(renderer->parallax));
+
+    // Costanti condivise tra C e GLSL, passate come #define a tutti gli shader
+    snprintf(renderer->shaderDefines, sizeof(renderer->shaderDefines),
+             "#define SPRITE_CHUNK_SIZE %.1f\n#define SPRITE_MAX_PARALLAX %d\n#define TILEMAP_DRAW_BATCH %d\n"
+             "#define TEXTURE_LAYERS %d\n%s%s",
+             SPRITE_CHUNK_SIZE, SPRITE_MAX_PARALLAX, RENDERER_TILEMAP_BATCH, RENDERER_MAX_TEXTURE_LAYERS,
+             (flags & RENDERER_PACKED_INSTANCES) ? "#define PACKED_INSTANCES\n" : "",
+             (flags & RENDERER_VERTEX_PULLING) ? "#define VERTEX_PULLING\n" : "");
+
+    shader_cache_init();
+
+    // Initialize quad and instance buffer
+    init_quad(renderer);
+    if (!init_instance_buffer(renderer))
+    {
+        return 0;
+    }
+
+    if (!init_scene_target(renderer, screenWidth, screenHeight))
+    {
+        return 0;
+    }
+
+    // --- Load shaders at runtime ---
+    // Set up projection matrix (once, since it doesn't change)
+    mat4x4_ortho(renderer->projection, 0.0f, RENDERER_GAME_WIDTH, RENDERER_GAME_HEIGHT, 0.0f, -1.0f, 1.0f);
+
+    // Le permutazioni si accodano tutte prima di aspettarne una: con
+    // KHR_parallel_shader_compile il driver le compila in parallelo
+    if (GLAD_GL_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // quanti thread vuole il driver
+    begin_sprite_builds(renderer);
+    bool spriteProgramsOk = true;
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            renderer->shaderPrograms[p][v] = shader_build_finish(&renderer->spriteBuilds[p][v]);
+            if (!renderer->shaderPrograms[p][v])
+                spriteProgramsOk = false;
+            else
+                setup_sprite_program(renderer, p, v);
+        }
+    }
+    if (!spriteProgramsOk)
+    {
+        return 0; // Indicate failure
+    }
+
+    renderer->viewSize[0] = RENDERER_GAME_WIDTH;
+    renderer->viewSize[1] = RENDERER_GAME_HEIGHT;
+
+    if (!init_tilemap(renderer))
+    {
+        return 0;
+    }
+
+    // Il culling su GPU è opzionale: senza compute program si ripiega su quello su CPU
+    renderer->cullMode = RENDERER_CULL_GPU;
+    if (!init_culling(renderer))
+    {
+        fprintf(stderr, "Culling su GPU non disponibile, uso il culling su CPU\n");
+        renderer->cullProgram = 0;
+        renderer->cullMode = RENDERER_CULL_CPU;
+    }
+
+    int cachedPrograms, compiledPrograms;
+    shader_cache_stats(&cachedPrograms, &compiledPrograms);
+    printf("Shader: %d programmi dalla cache, %d compilati\n", cachedPrograms, compiledPrograms);
+
+    renderer->shadersReloading = false;
+    renderer->shaderWatch.fd = -1;
+    renderer->profiler = NULL;
+    if ((flags & RENDERER_SHADER_HOT_RELOAD) && !shader_watch_init(&renderer->shaderWatch, "shaders"))
+        fprintf(stderr, "Ricarica degli shader non disponibile\n");
+
+    // Senza un loader avviato dal chiamante si decodifica adesso
+    TextureLoader localTextures;
+    if (!textures)
+    {
+        texture_loader_start(&localTextures, 0);
+        textures = &localTextures;
+    }
+    if (!init_texture_array(renderer, textures))
+    {
+        return 0;
+    }
 
     // abilità il depth test
     glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL); // o GL_LESS, a seconda delle tue necessità
+    glDepthFunc(GL_LESS); // vedi renderer_draw_pass per i pareggi
 
     return 1; // Indicate success
 }
 
+// Fine del caricamento di uno slot (texture_stream_update, thread GL)
+static void layer_streamed(void *user, int slot, bool ok, bool translucent)
+{
+    Renderer *renderer = user;
+    int layer = renderer->residency.layerOf[slot];
+    if (layer == TEXTURE_RESIDENCY_NONE)
+        return;
+    translucent = translucent && !layer_is_atlas_page(renderer, layer);
+    if (ok && renderer->layerTranslucent[layer] != translucent)
+    {
+        // La passata delle decorazioni che lo usano cambia: le loro chiavi vanno rifatte
+        renderer->layerTranslucent[layer] = translucent;
+        renderer->staticKeysStale = true;
+    }
+    texture_residency_loaded(&renderer->residency, slot, ok);
+
+    TextureStreamCallback callback = renderer->layerCallback[layer];
+    renderer->layerCallback[layer] = NULL;
+    if (callback)
+        callback(renderer->layerCallbackUser[layer], layer, ok, translucent);
+}
+
+static bool load_layer(Renderer *renderer, int layer, uint64_t referenced)
+{
+    int slot = texture_residency_acquire(&renderer->residency, layer, referenced);
+    if (slot == TEXTURE_RESIDENCY_NONE)
+        return false;
+    if (!texture_stream_request(&renderer->textureStream, slot, renderer->residency.paths[layer], layer_streamed, renderer))
+    {
+        texture_residency_cancel(&renderer->residency, slot);
+        return false;
+    }
+    return true;
+}
+
+// Carica i layer usati da questo frame che non sono residenti, sfrattando i meno usati di recente
+static void update_residency(Renderer *renderer)
+{
+    uint64_t referenced = renderer->staticLayers | renderer->tileLayers | renderer->frameLayers;
+    texture_residency_touch(&renderer->residency, referenced);
+    for (int layer = 0; layer < renderer->residency.layerCount; layer++)
+    {
+        if ((referenced >> layer & 1) && texture_residency_missing(&renderer->residency, layer))
+            load_layer(renderer, layer, referenced);
+    }
+}
+
+static uint64_t layer_bit(float layerIndex)
+{
+    int layer = (int)layerIndex;
+    return (layer >= 0 && layer < RENDERER_MAX_TEXTURE_LAYERS) ? 1ull << layer : 0;
+}
+
+bool renderer_stream_layer(Renderer *renderer, int layer, const char *path, TextureStreamCallback callback, void *user)
+{
+    if (layer < 0 || layer >= RENDERER_MAX_TEXTURE_LAYERS || (renderer->residency.loading >> layer & 1))
+        return false;
+    texture_residency_set_path(&renderer->residency, layer, path);
+    renderer->layerCallback[layer] = callback;
+    renderer->layerCallbackUser[layer] = user;
+    if (!load_layer(renderer, layer, renderer->staticLayers | renderer->tileLayers | renderer->frameLayers))
+    {
+        renderer->layerCallback[layer] = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Accoda la ricompilazione di tutti i programmi; quelli con i sorgenti invariati
+// vengono subito dalla cache degli shader
+static void begin_shader_reload(Renderer *renderer)
+{
+    begin_sprite_builds(renderer);
+    shader_build_begin(&renderer->tileBuild, "shaders/tilemap.vert", "shaders/tilemap.frag", renderer->shaderDefines);
+    if (renderer->cullProgram)
+        shader_build_begin(&renderer->cullBuild, "shaders/sprite_cull.comp", NULL, renderer->shaderDefines);
+    renderer->shadersReloading = true;
+}
+
+// Quando tutti i programmi sono linkati li sostituisce insieme; se uno fallisce
+// restano tutti quelli vecchi
+static void finish_shader_reload(Renderer *renderer)
+{
+    bool ready = shader_build_ready(&renderer->tileBuild) && (!renderer->cullProgram || shader_build_ready(&renderer->cullBuild));
+    for (int p = 0; p < RENDER_PASS_COUNT && ready; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT && ready; v++)
+            ready = shader_build_ready(&renderer->spriteBuilds[p][v]);
+    }
+    if (!ready)
+        return;
+    renderer->shadersReloading = false;
+
+    GLuint sprite[RENDER_PASS_COUNT][SPRITE_VARIANT_COUNT];
+    bool ok = true;
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            sprite[p][v] = shader_build_finish(&renderer->spriteBuilds[p][v]);
+            ok = ok && sprite[p][v];
+        }
+    }
+    GLuint tile = shader_build_finish(&renderer->tileBuild);
+    GLuint cull = renderer->cullProgram ? shader_build_finish(&renderer->cullBuild) : 0;
+    ok = ok && tile && (!renderer->cullProgram || cull);
+
+    if (!ok)
+    {
+        // glDeleteProgram ignora lo 0
+        for (int p = 0; p < RENDER_PASS_COUNT; p++)
+        {
+            for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+                glDeleteProgram(sprite[p][v]);
+        }
+        glDeleteProgram(tile);
+        glDeleteProgram(cull);
+        fprintf(stderr, "Ricarica degli shader fallita: restano i programmi precedenti\n");
+        return;
+    }
+
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            glDeleteProgram(renderer->shaderPrograms[p][v]);
+            renderer->shaderPrograms[p][v] = sprite[p][v];
+            setup_sprite_program(renderer, p, v);
+        }
+    }
+    glDeleteProgram(renderer->tileProgram);
+    renderer->tileProgram = tile;
+    setup_tile_program(renderer);
+    if (cull)
+    {
+        glDeleteProgram(renderer->cullProgram);
+        renderer->cullProgram = cull;
+        setup_cull_program(renderer);
+    }
+    // Gli uniform che non si riscrivono a ogni frame
+    renderer->residency.changed = true;
+    renderer->parallax.dirty = 1;
+    printf("Shader ricaricati\n");
+}
+
+// La camera si muove di frazioni di pixel: sprite, tile e culling la vedono arrotondata al
+// pixel di gioco (come floor(x + 0.5) in sprite.vert), così la scena non tremola
+static void game_pixel_camera(vec2 camera)
+{
+    camera[0] = floorf(game.camera_pos[0] + 0.5f);
+    camera[1] = floorf(game.camera_pos[1] + 0.5f);
+}
+
 void renderer_begin_frame(Renderer *renderer)
 {
+    // Una nuova modifica durante una ricarica resta in coda a inotify fino alla fine di questa
+    if (renderer->shadersReloading)
+        finish_shader_reload(renderer);
+    else if (shader_watch_poll(&renderer->shaderWatch))
+        begin_shader_reload(renderer);
+
+    // Passa alla prossima regione del ring e aspetta che la GPU l'abbia rilasciata
+    renderer->frameRegion = (renderer->frameRegion + 1) % RENDERER_FRAMES_IN_FLIGHT;
+    wait_instance_region(renderer, renderer->frameRegion);
+
+    profiler_gpu_begin(renderer->profiler, PROFILE_GPU_SETUP);
+    texture_stream_update(&renderer->textureStream);
+    if (renderer->residency.changed)
+    {
+        GLint layerMap[RENDERER_MAX_TEXTURE_LAYERS];
+        for (int i = 0; i < RENDERER_MAX_TEXTURE_LAYERS; i++)
+            layerMap[i] = renderer->residency.slotOf[i];
+        for (int p = 0; p < RENDER_PASS_COUNT; p++)
+        {
+            for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+            {
+                glProgramUniform1iv(renderer->shaderPrograms[p][v], layerMapLoc[p][v], RENDERER_MAX_TEXTURE_LAYERS, layerMap);
+            }
+        }
+        renderer->residency.changed = false;
+    }
+
+    // Tutte le passate disegnano nel target a risoluzione di gioco
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer->sceneFBO);
+    glViewport(0, 0, RENDERER_GAME_WIDTH, RENDERER_GAME_HEIGHT);
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glUniform2f(cameraPosLoc, game.camera_pos[0], game.camera_pos[1]);
+    vec2 camera;
+    game_pixel_camera(camera);
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            glProgramUniform2f(renderer->shaderPrograms[p][v], cameraPosLoc[p][v], camera[0], camera[1]);
+        }
+    }
+    renderer->runCount = 0; // niente sprite dinamici finché renderer_submit_sprites non li carica
+    renderer->frameLayers = 0;
+
+    if (renderer->cullMode == RENDERER_CULL_GPU)
+    {
+        glUseProgram(renderer->cullProgram);
+        glUniform2f(cullCameraPosLoc, camera[0], camera[1]);
+        glUniform2f(cullViewSizeLoc, renderer->viewSize[0], renderer->viewSize[1]);
+    }
+    profiler_gpu_end(renderer->profiler, PROFILE_GPU_SETUP);
+}
+
+Sprite *renderer_frame_instances(Renderer *renderer)
+{
+    return renderer->staging;
+}
+
+// Upload della tabella di parallasse quando il pack ha aggiunto una coppia nuova
+void sync_parallax_table(Renderer *renderer)
+{
+    if (!renderer->parallax.dirty)
+        return;
+
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            glProgramUniform2fv(renderer->shaderPrograms[p][v], parallaxTableLoc[p][v], renderer->parallax.count,
+                                (const GLfloat *)renderer->parallax.factors);
+        }
+    }
+    if (renderer->cullProgram)
+        glProgramUniform2fv(renderer->cullProgram, cullParallaxTableLoc, renderer->parallax.count,
+                            (const GLfloat *)renderer->parallax.factors);
+    renderer->parallax.dirty = 0;
 }
 
-void renderer_draw_sprites(Renderer *renderer, Sprite *sprites, size_t numSprites)
+size_t renderer_frame_offset(Renderer *renderer)
 {
+    return renderer->frameRegion * renderer->maxSprites;
+}
 
-    update_instance_buffer(renderer, sprites, numSprites);
+// Primo slot di VisibleBuffer (e primo comando indiretto) riservato a ciascun batch
+size_t batch_visible_base(RendererBatch batch)
+{
+    return batch == RENDERER_BATCH_STATIC ? 0 : MAX_STATIC_OBJECTS;
+}
 
-    glUseProgram(renderer->shaderProgram);
+// Disegna un run del batch; le istanze del batch iniziano a firstSprite in buffer
+void draw_run(Renderer *renderer, RendererBatch batch, GLuint buffer, size_t firstSprite, const RenderRun *run, size_t runIndex)
+{
+    RenderPass pass = run->pass;
+    GLuint program = renderer->shaderPrograms[pass][run->variant];
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+
+    if (renderer->cullMode != RENDERER_CULL_GPU)
+    {
+        glUseProgram(program);
+        glUniform1i(useVisibleListLoc[pass][run->variant], 0);
+        glUniform1i(instanceOffsetLoc[pass][run->variant], (GLint)(firstSprite + run->first));
+        glBindVertexArray(renderer->quadVAO);
+        glDrawArraysInstanced(renderer->quadMode, 0, renderer->quadVertexCount, run->count);
+        glBindVertexArray(0);
+        return;
+    }
+
+    // Culling: il compute shader compatta gli sprite visibili e scrive instanceCount del comando.
+    // Ogni run ha il suo comando, azzerato da reset_draw_commands prima delle passate.
+    size_t visibleBase = batch_visible_base(batch) + run->first;
+    size_t command = batch_visible_base(batch) + runIndex;
+
+    glUseProgram(renderer->cullProgram);
+    glUniform1i(cullInstanceOffsetLoc, (GLint)(firstSprite + run->first));
+    glUniform1ui(cullSpriteCountLoc, (GLuint)run->count);
+    glUniform1i(cullVisibleBaseLoc, (GLint)visibleBase);
+    glUniform1i(cullCommandIndexLoc, (GLint)command);
+    glDispatchCompute((GLuint)((run->count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    glUseProgram(program);
+    glUniform1i(useVisibleListLoc[pass][run->variant], 1);
+    glUniform1i(visibleBaseLoc[pass][run->variant], (GLint)visibleBase);
     glBindVertexArray(renderer->quadVAO);
-    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, numSprites);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer->drawCommandBuffer);
+    glDrawArraysIndirect(renderer->quadMode, (const void *)(command * sizeof(DrawArraysIndirectCommand)));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
     glBindVertexArray(0);
 }
 
+// Azzera i comandi indiretti dei run di un batch con un riempimento sulla GPU: il
+// comando da 16 byte si ripete come un texel RGBA32UI, senza upload dalla CPU
+static void reset_batch_commands(Renderer *renderer, RendererBatch batch, size_t runCount)
+{
+    if (runCount == 0)
+        return;
+    const GLuint reset[4] = {(GLuint)renderer->quadVertexCount, 0, 0, 0};
+    _Static_assert(sizeof(DrawArraysIndirectCommand) == sizeof(reset), "un comando indiretto è un texel RGBA32UI");
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_RGBA32UI,
+                         batch_visible_base(batch) * sizeof(DrawArraysIndirectCommand),
+                         runCount * sizeof(DrawArraysIndirectCommand), GL_RGBA_INTEGER, GL_UNSIGNED_INT, reset);
+}
+
+// Prima delle passate: i run di entrambi i batch sono noti dopo renderer_submit_sprites
+static void reset_draw_commands(Renderer *renderer)
+{
+    if (renderer->cullMode != RENDERER_CULL_GPU)
+        return;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->drawCommandBuffer);
+    reset_batch_commands(renderer, RENDERER_BATCH_STATIC, renderer->staticRunCount);
+    reset_batch_commands(renderer, RENDERER_BATCH_DYNAMIC, renderer->runCount);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+// Raggruppa le chiavi ordinate in run: un nuovo run a ogni cambio di passata o di variante
+size_t build_runs(const RenderQueue *queue, RenderRun *runs)
+{
+    size_t runCount = 0;
+    for (size_t i = 0; i < queue->count; i++)
+    {
+        RenderPass pass = render_key_pass(queue->keys[i]);
+        SpriteVariant variant = render_key_variant(queue->keys[i]);
+        if (runCount == 0 || runs[runCount - 1].pass != pass || runs[runCount - 1].variant != variant)
+        {
+            runs[runCount].first = (uint32_t)i;
+            runs[runCount].count = 0;
+            runs[runCount].pass = pass;
+            runs[runCount].variant = variant;
+            runCount++;
+        }
+        runs[runCount - 1].count++;
+    }
+    return runCount;
+}
+
+// Passata di uno sprite: su una pagina dell'atlas è opaco solo se campiona una regione
+// opaca; un layer fuori dall'atlas è una sola immagine e vale il suo flag
+RenderPass sprite_pass(const Renderer *renderer, const Sprite *sprite)
+{
+    int layer = (int)sprite->layerIndex;
+    if (layer < 0 || layer >= RENDERER_MAX_TEXTURE_LAYERS || renderer->layerTranslucent[layer])
+        return RENDER_PASS_TRANSLUCENT;
+    if (layer_is_atlas_page(renderer, layer))
+    {
+        const AtlasRegion *region = atlas_find_uv(&renderer->atlas, layer, sprite->uvStart, sprite->uvEnd);
+        if (!region || !(region->flags & ATLAS_REGION_OPAQUE))
+            return RENDER_PASS_TRANSLUCENT;
+    }
+    return RENDER_PASS_OPAQUE;
+}
+
+// Copia uno sprite nel formato delle istanze GPU (Sprite o PackedSprite)
+static void write_instance(Renderer *renderer, void *instances, size_t index, const Sprite *sprite)
+{
+    if (renderer->flags & RENDERER_PACKED_INSTANCES)
+        sprite_pack(sprite, &renderer->parallax, (PackedSprite *)instances + index);
+    else
+        ((Sprite *)instances)[index] = *sprite;
+}
+
+void renderer_submit_sprites(Renderer *renderer, size_t firstSprite, size_t numSprites)
+{
+    RenderQueue *queue = &renderer->queue;
+
+    // La chiave i-esima è quella di staging[i]; sprite scritti nello staging senza
+    // passare da renderer_set_sprites vengono trattati come entità
+    if (queue->count > numSprites)
+        queue->count = numSprites;
+    for (size_t i = queue->count; i < numSprites; i++)
+    {
+        const Sprite *sprite = &renderer->staging[i];
+        render_queue_push(queue, render_sort_key(sprite, sprite_pass(renderer, sprite), RENDER_LAYER_ENTITIES), (uint32_t)i);
+    }
+    render_queue_sort(queue);
+
+    void *region = (char *)renderer->instanceRing + firstSprite * renderer->instanceStride;
+    for (size_t i = 0; i < queue->count; i++)
+    {
+        write_instance(renderer, region, i, &renderer->staging[queue->items[i]]);
+    }
+    sync_parallax_table(renderer);
+
+    renderer->runFirstSprite = firstSprite;
+    renderer->runCount = build_runs(queue, renderer->runs);
+    render_queue_clear(queue);
+    reset_draw_commands(renderer);
+}
+
+// Riordina tutte le decorazioni per chiave e ricarica il buffer statico
+static void rebuild_static(Renderer *renderer, const Sprite *decorazioni, size_t count)
+{
+    RenderQueue *queue = &renderer->staticQueue;
+    render_queue_clear(queue);
+    renderer->staticLayers = 0;
+    renderer->staticKeysStale = false;
+    for (size_t i = 0; i < count; i++)
+    {
+        renderer->staticLayers |= layer_bit(decorazioni[i].layerIndex);
+        renderer->staticKey[i] = render_sort_key(&decorazioni[i], sprite_pass(renderer, &decorazioni[i]), RENDER_LAYER_DECORATIONS);
+        render_queue_push(queue, renderer->staticKey[i], (uint32_t)i);
+    }
+    render_queue_sort(queue);
+
+    for (size_t slot = 0; slot < count; slot++)
+    {
+        uint32_t i = queue->items[slot];
+        renderer->staticSlot[i] = (uint32_t)slot;
+        write_instance(renderer, renderer->staticMirror, slot, &decorazioni[i]);
+    }
+    renderer->staticRunCount = build_runs(queue, renderer->staticRuns);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->staticSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * renderer->instanceStride, renderer->staticMirror);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void renderer_sync_static(Renderer *renderer, GameWorld *world)
+{
+    size_t count = world->count_decorazioni;
+    size_t first = world->decorazioni_dirty_begin;
+    size_t last = world->decorazioni_dirty_end;
+    if (last > count)
+        last = count;
+
+    // Se cambia la chiave di una decorazione (o il numero di decorazioni) l'ordine va rifatto;
+    // altrimenti ogni decorazione resta nel suo slot e basta aggiornarlo
+    bool rebuild = count != renderer->staticCount || renderer->staticKeysStale;
+    for (size_t i = first; i < last && !rebuild; i++)
+    {
+        rebuild = render_sort_key(&world->decorazioni[i], sprite_pass(renderer, &world->decorazioni[i]), RENDER_LAYER_DECORATIONS) != renderer->staticKey[i];
+    }
+
+    if (rebuild)
+    {
+        rebuild_static(renderer, world->decorazioni, count);
+    }
+    else if (first < last)
+    {
+        // Le decorazioni con la stessa chiave sono contigue: di solito l'intervallo degli slot
+        // toccati è stretto quanto quello delle decorazioni modificate
+        size_t lo = SIZE_MAX, hi = 0;
+        for (size_t i = first; i < last; i++)
+        {
+            size_t slot = renderer->staticSlot[i];
+            write_instance(renderer, renderer->staticMirror, slot, &world->decorazioni[i]);
+            renderer->staticLayers |= layer_bit(world->decorazioni[i].layerIndex);
+            if (slot < lo)
+                lo = slot;
+            if (slot + 1 > hi)
+                hi = slot + 1;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->staticSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, lo * renderer->instanceStride, (hi - lo) * renderer->instanceStride,
+                        (char *)renderer->staticMirror + lo * renderer->instanceStride);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    sync_parallax_table(renderer);
+
+    renderer->staticCount = count;
+    world->decorazioni_dirty_begin = 0;
+    world->decorazioni_dirty_end = 0;
+}
+
+void renderer_draw_pass(Renderer *renderer, RenderPass pass)
+{
+    // Gli opachi scrivono la profondità senza blending; i traslucidi la testano soltanto.
+    // GL_LESS: a parità di profondità vince il primo disegnato, cioè il layer più alto
+    // tra gli opachi (ordinati al contrario) e l'opaco rispetto al traslucido.
+    ProfileGpuZone zone = pass == RENDER_PASS_OPAQUE ? PROFILE_GPU_OPAQUE : PROFILE_GPU_TRANSLUCENT;
+    profiler_gpu_begin(renderer->profiler, zone);
+    if (pass == RENDER_PASS_TRANSLUCENT)
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    }
+
+    // Con il culling su CPU le decorazioni visibili viaggiano nel ring insieme alle entità
+    if (renderer->cullMode != RENDERER_CULL_CPU)
+    {
+        for (size_t r = 0; r < renderer->staticRunCount; r++)
+        {
+            if (renderer->staticRuns[r].pass == pass)
+                draw_run(renderer, RENDERER_BATCH_STATIC, renderer->staticSSBO, 0, &renderer->staticRuns[r], r);
+        }
+    }
+    for (size_t r = 0; r < renderer->runCount; r++)
+    {
+        if (renderer->runs[r].pass == pass)
+            draw_run(renderer, RENDERER_BATCH_DYNAMIC, renderer->instanceSSBO, renderer->runFirstSprite, &renderer->runs[r], r);
+    }
+
+    if (pass == RENDER_PASS_TRANSLUCENT)
+    {
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE); // glClear del prossimo frame rispetta la depth mask
+    }
+    profiler_gpu_end(renderer->profiler, zone);
+}
+
+void renderer_sync_tilemap(Renderer *renderer, TileMap *map)
+{
+    if (map->width != renderer->tileIndexWidth || map->height != renderer->tileIndexHeight)
+    {
+        // Storage immutabile: con una stanza di dimensioni diverse si ricrea la texture
+        if (renderer->tileIndexTexture)
+            glDeleteTextures(1, &renderer->tileIndexTexture);
+        renderer->tileIndexTexture = 0;
+        renderer->tileIndexWidth = map->width;
+        renderer->tileIndexHeight = map->height;
+        if (map->width <= 0 || map->height <= 0)
+        {
+            // Stanza vuota o liberata: draw_tilemap non disegna niente senza texture
+            renderer->tileLayers = 0;
+            return;
+        }
+        glGenTextures(1, &renderer->tileIndexTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, renderer->tileIndexTexture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, map->width, map->height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glActiveTexture(GL_TEXTURE0);
+
+        map->dirtyX0 = 0;
+        map->dirtyY0 = 0;
+        map->dirtyX1 = map->width;
+        map->dirtyY1 = map->height;
+    }
+
+    if (map->dirtyX0 < map->dirtyX1 && map->dirtyY0 < map->dirtyY1)
+    {
+        // Solo il rettangolo modificato, letto direttamente dalla griglia della stanza
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, renderer->tileIndexTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, map->width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, map->dirtyX0, map->dirtyY0,
+                        map->dirtyX1 - map->dirtyX0, map->dirtyY1 - map->dirtyY0,
+                        GL_RED_INTEGER, GL_UNSIGNED_SHORT,
+                        &map->tiles[(size_t)map->dirtyY0 * map->width + map->dirtyX0]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    map->dirtyX0 = map->dirtyY0 = map->dirtyX1 = map->dirtyY1 = 0;
+    renderer->tileLayers = layer_bit((float)map->tilesetLayer);
+}
+
+static void draw_tilemap(Renderer *renderer, const TileMap *map)
+{
+    int tilesetSlot = map->tilesetLayer >= 0 && map->tilesetLayer < RENDERER_MAX_TEXTURE_LAYERS
+                          ? renderer->residency.slotOf[map->tilesetLayer]
+                          : TEXTURE_RESIDENCY_NONE;
+    if (!renderer->tileIndexTexture || tilesetSlot == TEXTURE_RESIDENCY_NONE)
+        return;
+
+    // Chunk visibili e non vuoti, in tile; il livello non ha parallasse
+    CullView view = renderer_cull_view(renderer);
+    float chunkSize = TILEMAP_CHUNK_TILES * TILEMAP_TILE_SIZE;
+    int cx0 = (int)floorf(view.cameraX / chunkSize);
+    int cy0 = (int)floorf(view.cameraY / chunkSize);
+    int cx1 = (int)floorf((view.cameraX + view.width) / chunkSize);
+    int cy1 = (int)floorf((view.cameraY + view.height) / chunkSize);
+    if (cx0 < 0)
+        cx0 = 0;
+    if (cy0 < 0)
+        cy0 = 0;
+    if (cx1 >= map->chunksX)
+        cx1 = map->chunksX - 1;
+    if (cy1 >= map->chunksY)
+        cy1 = map->chunksY - 1;
+
+    glUseProgram(renderer->tileProgram);
+    glUniform2f(tileCameraPosLoc, view.cameraX, view.cameraY);
+    glUniform1f(tileZIndexLoc, map->zIndex);
+    glUniform1i(tileLayerLoc, tilesetSlot);
+    glUniform1i(tileColumnsLoc, map->tilesetColumns);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, renderer->tileIndexTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(renderer->tileVAO);
+
+    GLint rects[RENDERER_TILEMAP_BATCH][4];
+    GLsizei count = 0;
+    for (int cy = cy0; cy <= cy1; cy++)
+    {
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            if (tilemap_chunk_empty(map, cx, cy))
+                continue;
+            int x = cx * TILEMAP_CHUNK_TILES;
+            int y = cy * TILEMAP_CHUNK_TILES;
+            rects[count][0] = x;
+            rects[count][1] = y;
+            rects[count][2] = (x + TILEMAP_CHUNK_TILES <= map->width) ? TILEMAP_CHUNK_TILES : map->width - x;
+            rects[count][3] = (y + TILEMAP_CHUNK_TILES <= map->height) ? TILEMAP_CHUNK_TILES : map->height - y;
+            if (++count == RENDERER_TILEMAP_BATCH)
+            {
+                glUniform4iv(tileChunkRectsLoc, count, &rects[0][0]);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+                count = 0;
+            }
+        }
+    }
+    if (count)
+    {
+        glUniform4iv(tileChunkRectsLoc, count, &rects[0][0]);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    }
+    glBindVertexArray(0);
+}
+
+void renderer_draw_tilemap(Renderer *renderer, const TileMap *map)
+{
+    profiler_gpu_begin(renderer->profiler, PROFILE_GPU_TILEMAP);
+    draw_tilemap(renderer, map);
+    profiler_gpu_end(renderer->profiler, PROFILE_GPU_TILEMAP);
+}
+
+void renderer_cycle_cull_mode(Renderer *renderer)
+{
+    do
+    {
+        renderer->cullMode = (renderer->cullMode + 1) % RENDERER_CULL_MODE_COUNT;
+    } while (renderer->cullMode == RENDERER_CULL_GPU && !renderer->cullProgram);
+
+    const char *names[RENDERER_CULL_MODE_COUNT] = {"nessuno", "CPU", "GPU"};
+    printf("Culling: %s\n", names[renderer->cullMode]);
+}
+
+CullView renderer_cull_view(Renderer *renderer)
+{
+    vec2 camera;
+    game_pixel_camera(camera);
+    CullView view = {camera[0], camera[1], renderer->viewSize[0], renderer->viewSize[1]};
+    return view;
+}
+
 void renderer_end_frame(Renderer *renderer)
 {
-    // currently empty, but you could add more things to do at the end of a frame
+    // Bande nere attorno alla scena, poi un solo blit nearest: pixel art senza filtraggio
+    profiler_gpu_begin(renderer->profiler, PROFILE_GPU_BLIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer->windowFBO);
+    glViewport(0, 0, renderer->screenWidth, renderer->screenHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderer->sceneFBO);
+    glBlitFramebuffer(0, 0, RENDERER_GAME_WIDTH, RENDERER_GAME_HEIGHT, renderer->sceneRect[0], renderer->sceneRect[1],
+                      renderer->sceneRect[2], renderer->sceneRect[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderer->windowFBO);
+    profiler_gpu_end(renderer->profiler, PROFILE_GPU_BLIT);
+
+    // La regione del frame resta occupata finché la GPU non ha eseguito i draw appena inviati
+    renderer->frameFences[renderer->frameRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    update_residency(renderer);
 }
 
 void renderer_cleanup(Renderer *renderer)
 {
+    for (int i = 0; i < RENDERER_FRAMES_IN_FLIGHT; i++)
+    {
+        if (renderer->frameFences[i])
+            glDeleteSync(renderer->frameFences[i]);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->instanceSSBO);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    free(renderer->staging);
+    free(renderer->runs);
+    free(renderer->staticMirror);
+    free(renderer->staticSlot);
+    free(renderer->staticKey);
+    free(renderer->staticRuns);
+    render_queue_free(&renderer->queue);
+    render_queue_free(&renderer->staticQueue);
     glDeleteVertexArrays(1, &renderer->quadVAO);
+    glDeleteVertexArrays(1, &renderer->tileVAO);
+    glDeleteFramebuffers(1, &renderer->sceneFBO);
+    glDeleteRenderbuffers(1, &renderer->sceneColor);
+    glDeleteRenderbuffers(1, &renderer->sceneDepth);
+    glDeleteProgram(renderer->tileProgram);
+    if (renderer->tileIndexTexture)
+        glDeleteTextures(1, &renderer->tileIndexTexture);
+    texture_stream_free(&renderer->textureStream);
+    glDeleteTextures(1, &renderer->textureArray);
+    atlas_free(&renderer->atlas);
     glDeleteBuffers(1, &renderer->instanceSSBO);
-    glDeleteProgram(renderer->shaderProgram);
+    glDeleteBuffers(1, &renderer->staticSSBO);
+    if (renderer->cullProgram)
+    {
+        glDeleteBuffers(1, &renderer->visibleSSBO);
+        glDeleteBuffers(1, &renderer->drawCommandBuffer);
+        glDeleteProgram(renderer->cullProgram);
+    }
+    for (int p = 0; p < RENDER_PASS_COUNT; p++)
+    {
+        for (int v = 0; v < SPRITE_VARIANT_COUNT; v++)
+        {
+            glDeleteProgram(renderer->shaderPrograms[p][v]);
+            if (renderer->shadersReloading)
+                glDeleteProgram(shader_build_finish(&renderer->spriteBuilds[p][v]));
+        }
+    }
+    if (renderer->shadersReloading)
+    {
+        glDeleteProgram(shader_build_finish(&renderer->tileBuild));
+        if (renderer->cullProgram)
+            glDeleteProgram(shader_build_finish(&renderer->cullBuild));
+    }
+    shader_watch_free(&renderer->shaderWatch);
+}
+
+// Sprite di un'entità dinamica: per ora tutte usano la prima cella dell'atlas del layer 1
+void entity_sprite(Sprite *sprite, const Transform *transform)
+{
+    vec2 uvStart = {0.0f, 0.0f};
+    vec2 uvEnd = {1.0f / 8.0f, 1.0f / 8.0f};
+    sprite_init(sprite,
+                transform->x + transform->width * 0.5f, transform->y + transform->height * 0.5f,
+                transform->width, transform->height,
+                uvStart, uvEnd, 1.0f, 1.0f, 1.0f, 1.0f);
+    sprite->color[0] = 1.0f;
+    sprite->color[1] = 1.0f;
+    sprite->color[2] = 1.0f;
+}
+
+// Accoda uno sprite del gather insieme alla sua chiave di ordinamento
+static void gather_sprite(Renderer *renderer, Sprite *drawing, size_t *count, const Sprite *sprite, RenderLayer layer)
+{
+    drawing[*count] = *sprite;
+    renderer->frameLayers |= layer_bit(sprite->layerIndex);
+    render_queue_push(&renderer->queue, render_sort_key(sprite, sprite_pass(renderer, sprite), layer), (uint32_t)*count);
+    (*count)++;
 }
 
-size_t renderer_set_sprites(GameWorld *world, Sprite *drawing)
+size_t renderer_set_sprites(Renderer *renderer, GameWorld *world, Sprite *drawing)
 {
+    // Le decorazioni vivono nella regione statica (renderer_sync_static):
+    // qui si raccoglie solo ciò che si muove ogni frame
     size_t count = 0;
-    memcpy(drawing, world->decorazioni, sizeof(Sprite) * world->count_decorazioni);
-    count += world->count_decorazioni;
-    // Copia i nemici nel buffer dopo le decorazioni
-    // memcpy(drawing + count, enemies, sizeof(Sprite) * world->count_enemies;
+    size_t capacity = renderer->maxSprites;
+    bool cpuCulling = renderer->cullMode == RENDERER_CULL_CPU;
+    CullView view = renderer_cull_view(renderer);
+    render_queue_clear(&renderer->queue);
+
+    if (cpuCulling)
+    {
+        // Solo le decorazioni visibili finiscono nel ring
+        size_t visible = cull_sprites(world->decorazioni, world->count_decorazioni, &view, visibleDecorations);
+        if (visible > capacity)
+            visible = capacity;
+        for (size_t i = 0; i < visible; i++)
+        {
+            gather_sprite(renderer, drawing, &count, &world->decorazioni[visibleDecorations[i]], RENDER_LAYER_DECORATIONS);
+        }
+    }
+
+    Sprite sprite;
+    if (world->player.is_active && count < capacity)
+    {
+        entity_sprite(&sprite, &world->player.transform);
+        if (!cpuCulling || cull_sprite_visible(&sprite, &view))
+            gather_sprite(renderer, drawing, &count, &sprite, RENDER_LAYER_ENTITIES);
+    }
+    for (int i = 0; i < world->enemy_count && count < capacity; i++)
+    {
+        if (!world->enemies[i].is_active)
+            continue;
+        entity_sprite(&sprite, &world->enemies[i].transform);
+        if (!cpuCulling || cull_sprite_visible(&sprite, &view))
+            gather_sprite(renderer, drawing, &count, &sprite, RENDER_LAYER_ENTITIES);
+    }
+    for (int i = 0; i < world->projectile_count && count < capacity; i++)
+    {
+        if (!world->projectiles[i].is_active)
+            continue;
+        entity_sprite(&sprite, &world->projectiles[i].transform);
+        if (!cpuCulling || cull_sprite_visible(&sprite, &view))
+            gather_sprite(renderer, drawing, &count, &sprite, RENDER_LAYER_ENTITIES);
+    }
     return count;
-}
\ No newline at end of file
+}
@@ -0,0 +1,136 @@
+#include "shader_cache.h"
+#include "hash.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(ShaderCacheHeader) == 32, "il formato della cache assume un header da 32 byte");
+
+static bool cacheEnabled;
+static uint64_t deviceHash;
+static int loadedCount, compiledCount;
+
+static uint64_t hash_string(uint64_t hash, const char *string)
+{
+    // Anche il terminatore: "ab" + "c" e "a" + "bc" non devono collidere
+    return hash_fnv1a(hash, string ? string : "", string ? strlen(string) + 1 : 1);
+}
+
+static void cache_path(uint64_t key, char *out, size_t size)
+{
+    snprintf(out, size, "%s/shader_%016llx.bin", SHADER_CACHE_DIR, (unsigned long long)key);
+}
+
+void shader_cache_init(void)
+{
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    cacheEnabled = formats > 0;
+
+    uint64_t hash = HASH_FNV1A_SEED;
+    hash = hash_string(hash, (const char *)glGetString(GL_VENDOR));
+    hash = hash_string(hash, (const char *)glGetString(GL_RENDERER));
+    hash = hash_string(hash, (const char *)glGetString(GL_VERSION));
+    deviceHash = hash;
+}
+
+uint64_t shader_cache_key(const char *const *sources, int count)
+{
+    uint64_t hash = HASH_FNV1A_SEED;
+    for (int i = 0; i < count; i++)
+    {
+        hash = hash_string(hash, sources[i]);
+    }
+    return hash;
+}
+
+GLuint shader_cache_load(uint64_t key)
+{
+    if (!cacheEnabled)
+        return 0;
+
+    char path[256];
+    cache_path(key, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return 0;
+
+    ShaderCacheHeader header;
+    void *binary = NULL;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == SHADER_CACHE_MAGIC &&
+              header.version == SHADER_CACHE_VERSION && header.sourceHash == key && header.deviceHash == deviceHash;
+    if (ok)
+    {
+        binary = malloc(header.binaryLength);
+        ok = binary && fread(binary, 1, header.binaryLength, file) == header.binaryLength;
+    }
+    fclose(file);
+    if (!ok)
+    {
+        free(binary);
+        return 0;
+    }
+
+    // Il driver può rifiutare il binario (es. dopo un aggiornamento): si ricompila
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary, (GLsizei)header.binaryLength);
+    free(binary);
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    loadedCount++;
+    return program;
+}
+
+void shader_cache_store(GLuint program, uint64_t key)
+{
+    compiledCount++;
+    if (!cacheEnabled)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    void *binary = malloc(length);
+    if (!binary)
+        return;
+    GLenum format;
+    glGetProgramBinary(program, length, &length, &format, binary);
+
+    if (mkdir(SHADER_CACHE_DIR, 0755) != 0 && errno != EEXIST)
+    {
+        perror(SHADER_CACHE_DIR);
+        free(binary);
+        return;
+    }
+    ShaderCacheHeader header = {SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, key, deviceHash, format, (uint32_t)length};
+
+    // File temporaneo + rename, come per la cache delle texture
+    char path[256], tmpPath[272];
+    cache_path(key, path, sizeof(path));
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d.tmp", path, (int)getpid());
+    FILE *file = fopen(tmpPath, "wb");
+    bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary, 1, length, file) == (size_t)length;
+    if (file && fclose(file) != 0)
+        ok = false;
+    if (!ok || rename(tmpPath, path) != 0)
+    {
+        fprintf(stderr, "Impossibile scrivere la cache degli shader %s\n", path);
+        remove(tmpPath);
+    }
+    free(binary);
+}
+
+void shader_cache_stats(int *loaded, int *compiled)
+{
+    *loaded = loadedCount;
+    *compiled = compiledCount;
+}
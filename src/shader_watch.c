@@ -0,0 +1,70 @@
+#include "shader_watch.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static bool is_shader_file(const char *name)
+{
+    static const char *extensions[] = {".vert", ".frag", ".comp", ".glsl"};
+    const char *dot = strrchr(name, '.');
+    if (!dot)
+        return false;
+    for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++)
+    {
+        if (strcmp(dot, extensions[i]) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool shader_watch_init(ShaderWatch *watch, const char *directory)
+{
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watch->watch = -1;
+    if (watch->fd < 0)
+    {
+        perror("inotify_init1");
+        return false;
+    }
+    // CLOSE_WRITE per chi salva sul file, MOVED_TO per chi scrive un temporaneo e lo rinomina
+    watch->watch = inotify_add_watch(watch->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch->watch < 0)
+    {
+        perror(directory);
+        shader_watch_free(watch);
+        return false;
+    }
+    return true;
+}
+
+bool shader_watch_poll(ShaderWatch *watch)
+{
+    if (watch->fd < 0)
+        return false;
+
+    bool changed = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;)
+    {
+        ssize_t length = read(watch->fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break; // EAGAIN: nessun altro evento
+        for (char *p = buffer; p < buffer + length;)
+        {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len && is_shader_file(event->name))
+                changed = true;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+void shader_watch_free(ShaderWatch *watch)
+{
+    if (watch->fd >= 0)
+        close(watch->fd);
+    watch->fd = -1;
+    watch->watch = -1;
+}
@@ -0,0 +1,136 @@
+#include "solid_grid.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(SOLID_GRID_TILE_PIXELS == (int)TILEMAP_TILE_SIZE, "SOLID_GRID_TILE_PIXELS deve valere TILEMAP_TILE_SIZE");
+_Static_assert(SOLID_GRID_TILE_PIXELS == 8, "pixel_to_tile divide con uno shift di 3");
+
+// Shift aritmetico: divisione per difetto anche per i negativi, -1 px sta nel tile -1
+static int pixel_to_tile(int pixel)
+{
+    return pixel >> 3;
+}
+
+// Tile [x0, x1] x [y0, y1] coperti dal rettangolo, ritagliati sulla mappa; false se vuoto
+static bool tile_range(const SolidGrid *grid, int x, int y, int w, int h, int *x0, int *y0, int *x1, int *y1)
+{
+    int tx0 = pixel_to_tile(x), ty0 = pixel_to_tile(y);
+    int tx1 = pixel_to_tile(x + w - 1), ty1 = pixel_to_tile(y + h - 1);
+    *x0 = tx0 > 0 ? tx0 : 0;
+    *y0 = ty0 > 0 ? ty0 : 0;
+    *x1 = tx1 < grid->width - 1 ? tx1 : grid->width - 1;
+    *y1 = ty1 < grid->height - 1 ? ty1 : grid->height - 1;
+    return w > 0 && h > 0 && *x0 <= *x1 && *y0 <= *y1;
+}
+
+// Maschera dei bit [x0, x1] dentro la parola word
+static uint64_t word_mask(int word, int x0, int x1)
+{
+    uint64_t mask = ~0ull;
+    if (word == x0 >> 6)
+        mask &= ~0ull << (x0 & 63);
+    if (word == x1 >> 6)
+        mask &= ~0ull >> (63 - (x1 & 63));
+    return mask;
+}
+
+bool solid_grid_init(SolidGrid *grid, int width, int height)
+{
+    memset(grid, 0, sizeof(*grid));
+    grid->width = width;
+    grid->height = height;
+    grid->wordsPerRow = (width + 63) / 64;
+    grid->rows = calloc((size_t)grid->wordsPerRow * height, sizeof(uint64_t));
+    if (!grid->rows)
+    {
+        perror("Memory allocation failed");
+        return false;
+    }
+    return true;
+}
+
+void solid_grid_free(SolidGrid *grid)
+{
+    free(grid->rows);
+    grid->rows = NULL;
+    grid->width = grid->height = grid->wordsPerRow = 0;
+}
+
+bool solid_grid_build(SolidGrid *grid, const TileMap *map)
+{
+    solid_grid_free(grid);
+    if (!solid_grid_init(grid, map->width, map->height))
+        return false;
+    solid_grid_update(grid, map, 0, 0, map->width, map->height);
+    return true;
+}
+
+void solid_grid_update(SolidGrid *grid, const TileMap *map, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; y++)
+        for (int x = x0; x < x1; x++)
+            solid_grid_set(grid, x, y, tilemap_get(map, x, y) != TILEMAP_EMPTY);
+}
+
+void solid_grid_set(SolidGrid *grid, int x, int y, bool solid)
+{
+    if (x < 0 || y < 0 || x >= grid->width || y >= grid->height)
+        return;
+    uint64_t *word = &grid->rows[(size_t)y * grid->wordsPerRow + (x >> 6)];
+    uint64_t bit = 1ull << (x & 63);
+    *word = solid ? *word | bit : *word & ~bit;
+}
+
+bool solid_grid_get(const SolidGrid *grid, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= grid->width || y >= grid->height)
+        return false;
+    return (grid->rows[(size_t)y * grid->wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
+
+bool solid_grid_collide_rect(const SolidGrid *grid, int x, int y, int w, int h)
+{
+    int x0, y0, x1, y1;
+    if (!tile_range(grid, x, y, w, h, &x0, &y0, &x1, &y1))
+        return false;
+
+    int w0 = x0 >> 6, w1 = x1 >> 6;
+    if (w0 == w1)
+    {
+        // Il caso comune: il rettangolo sta in una parola, una AND per riga. Le righe di
+        // un attore sono poche: accumularle costa meno di un salto che il predittore sbaglia
+        uint64_t mask = word_mask(w0, x0, x1);
+        const uint64_t *word = &grid->rows[(size_t)y0 * grid->wordsPerRow + w0];
+        uint64_t hit = 0;
+        for (int ty = y0; ty <= y1; ty++, word += grid->wordsPerRow)
+            hit |= *word;
+        return (hit & mask) != 0;
+    }
+    for (int ty = y0; ty <= y1; ty++)
+    {
+        const uint64_t *row = &grid->rows[(size_t)ty * grid->wordsPerRow];
+        for (int wi = w0; wi <= w1; wi++)
+        {
+            if (row[wi] & word_mask(wi, x0, x1))
+                return true;
+        }
+    }
+    return false;
+}
+
+int solid_grid_count_rect(const SolidGrid *grid, int x, int y, int w, int h)
+{
+    int x0, y0, x1, y1;
+    if (!tile_range(grid, x, y, w, h, &x0, &y0, &x1, &y1))
+        return 0;
+
+    int count = 0;
+    for (int ty = y0; ty <= y1; ty++)
+    {
+        const uint64_t *row = &grid->rows[(size_t)ty * grid->wordsPerRow];
+        for (int wi = x0 >> 6; wi <= x1 >> 6; wi++)
+            count += __builtin_popcountll(row[wi] & word_mask(wi, x0, x1));
+    }
+    return count;
+}
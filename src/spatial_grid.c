@@ -0,0 +1,169 @@
+#include "spatial_grid.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t hash_cell(int cx, int cy)
+{
+    return ((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u);
+}
+
+static int cell_of(const SpatialGrid *grid, float v)
+{
+    return (int)floorf(v * grid->invCellSize);
+}
+
+// Raddoppia la capacità di un array finché non contiene needed elementi
+static bool grow(void **array, int *capacity, int needed, size_t elementSize)
+{
+    if (needed <= *capacity)
+        return true;
+    int newCapacity = *capacity ? *capacity : 64;
+    while (newCapacity < needed)
+        newCapacity *= 2;
+    void *p = realloc(*array, (size_t)newCapacity * elementSize);
+    if (!p)
+    {
+        perror("Memory allocation failed");
+        return false;
+    }
+    *array = p;
+    *capacity = newCapacity;
+    return true;
+}
+
+void spatial_grid_init(SpatialGrid *grid, float cellSize)
+{
+    memset(grid, 0, sizeof(*grid));
+    spatial_grid_clear(grid, cellSize);
+}
+
+void spatial_grid_free(SpatialGrid *grid)
+{
+    free(grid->ids);
+    free(grid->cellRanges);
+    free(grid->stamps);
+    free(grid->bucketStart);
+    free(grid->entries);
+    memset(grid, 0, sizeof(*grid));
+}
+
+void spatial_grid_clear(SpatialGrid *grid, float cellSize)
+{
+    grid->cellSize = cellSize;
+    grid->invCellSize = 1.0f / cellSize;
+    grid->itemCount = 0;
+    grid->entryCount = 0;
+    grid->bucketMask = 0;
+}
+
+// Gli array per elemento crescono insieme: itemCapacity si aggiorna solo se tutti ci riescono
+static bool reserve_items(SpatialGrid *grid, int needed)
+{
+    if (needed <= grid->itemCapacity)
+        return true;
+    int capacity = grid->itemCapacity;
+    if (!grow((void **)&grid->ids, &capacity, needed, sizeof(int)))
+        return false;
+    capacity = grid->itemCapacity;
+    if (!grow((void **)&grid->cellRanges, &capacity, needed, 4 * sizeof(int)))
+        return false;
+    capacity = grid->itemCapacity;
+    if (!grow((void **)&grid->stamps, &capacity, needed, sizeof(uint32_t)))
+        return false;
+    // Gli stamp nuovi non devono coincidere con quello di una query già fatta
+    memset(grid->stamps + grid->itemCapacity, 0, (size_t)(capacity - grid->itemCapacity) * sizeof(uint32_t));
+    grid->itemCapacity = capacity;
+    return true;
+}
+
+bool spatial_grid_insert(SpatialGrid *grid, int id, float x, float y, float width, float height)
+{
+    if (!reserve_items(grid, grid->itemCount + 1))
+        return false;
+
+    int item = grid->itemCount++;
+    grid->ids[item] = id;
+    int *range = &grid->cellRanges[item * 4];
+    range[0] = cell_of(grid, x);
+    range[1] = cell_of(grid, y);
+    range[2] = cell_of(grid, x + width);
+    range[3] = cell_of(grid, y + height);
+    grid->entryCount += (range[2] - range[0] + 1) * (range[3] - range[1] + 1);
+    return true;
+}
+
+bool spatial_grid_build(SpatialGrid *grid)
+{
+    // Almeno due bucket per voce: le celle occupate raramente condividono un bucket
+    int bucketCount = 16;
+    while (bucketCount < grid->entryCount * 2)
+        bucketCount *= 2;
+    int capacity = grid->bucketCapacity;
+    if (!grow((void **)&grid->bucketStart, &capacity, bucketCount + 1, sizeof(int)))
+        return false;
+    grid->bucketCapacity = capacity;
+    if (!grow((void **)&grid->entries, &grid->entryCapacity, grid->entryCount, sizeof(int)))
+        return false;
+    grid->bucketMask = (uint32_t)bucketCount - 1;
+
+    // Counting sort: conteggio per bucket, somma prefissa, poi ogni voce al suo posto.
+    // bucketStart[b + 1] conta il bucket b, così dopo la somma vale la fine di b
+    int *start = grid->bucketStart;
+    memset(start, 0, (size_t)(bucketCount + 1) * sizeof(int));
+    for (int item = 0; item < grid->itemCount; item++)
+    {
+        const int *range = &grid->cellRanges[item * 4];
+        for (int cy = range[1]; cy <= range[3]; cy++)
+            for (int cx = range[0]; cx <= range[2]; cx++)
+                start[(hash_cell(cx, cy) & grid->bucketMask) + 1]++;
+    }
+    for (int b = 0; b < bucketCount; b++)
+        start[b + 1] += start[b];
+    // Riempie usando start[b] come cursore: alla fine start[b] è l'inizio di b + 1,
+    // quindi si ripristina spostando tutto di un posto
+    for (int item = 0; item < grid->itemCount; item++)
+    {
+        const int *range = &grid->cellRanges[item * 4];
+        for (int cy = range[1]; cy <= range[3]; cy++)
+            for (int cx = range[0]; cx <= range[2]; cx++)
+                grid->entries[start[hash_cell(cx, cy) & grid->bucketMask]++] = item;
+    }
+    memmove(start + 1, start, (size_t)bucketCount * sizeof(int));
+    start[0] = 0;
+    return true;
+}
+
+int spatial_grid_query(SpatialGrid *grid, float x, float y, float width, float height, int *out, int max)
+{
+    if (grid->itemCount == 0 || grid->bucketMask == 0)
+        return 0;
+    if (++grid->queryStamp == 0)
+    {
+        memset(grid->stamps, 0, (size_t)grid->itemCapacity * sizeof(uint32_t));
+        grid->queryStamp = 1;
+    }
+
+    int x0 = cell_of(grid, x), y0 = cell_of(grid, y);
+    int x1 = cell_of(grid, x + width), y1 = cell_of(grid, y + height);
+    int found = 0;
+    for (int cy = y0; cy <= y1; cy++)
+    {
+        for (int cx = x0; cx <= x1; cx++)
+        {
+            uint32_t bucket = hash_cell(cx, cy) & grid->bucketMask;
+            for (int e = grid->bucketStart[bucket]; e < grid->bucketStart[bucket + 1]; e++)
+            {
+                int item = grid->entries[e];
+                if (grid->stamps[item] == grid->queryStamp)
+                    continue;
+                grid->stamps[item] = grid->queryStamp;
+                if (found < max)
+                    out[found] = grid->ids[item];
+                found++;
+            }
+        }
+    }
+    return found;
+}
@@ -1,5 +1,8 @@
 #include "sprite.h"
 #include <stdlib.h> // For possible memory allocation, if needed
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 void sprite_init(Sprite *sprite, float x, float y, float width, float height, vec2 uvStart, vec2 uvEnd, float layerIndex, float parX, float parY, float zIndex)
 {
@@ -27,4 +30,118 @@ void sprite_update(Sprite *sprite, float deltaTime)
     }
 }
 
+// IEEE 754 binary16, round to nearest even; overflow saturates to infinity
+uint16_t float_to_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu) // inf / NaN
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+
+    int halfExponent = (int)exponent - 127 + 15;
+    if (halfExponent >= 0x1F)
+        return (uint16_t)(sign | 0x7C00u);
+
+    if (halfExponent <= 0)
+    {
+        // Denormale (o zero) in half
+        if (halfExponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+        half++; // il riporto può salire nell'esponente, ed è corretto così
+    return (uint16_t)(sign | half);
+}
+
+static uint16_t float_to_unorm16(float value)
+{
+    if (value <= 0.0f)
+        return 0;
+    if (value >= 1.0f)
+        return 0xFFFF;
+    return (uint16_t)(value * 65535.0f + 0.5f);
+}
+
+static uint8_t float_to_unorm8(float value)
+{
+    if (value <= 0.0f)
+        return 0;
+    if (value >= 1.0f)
+        return 0xFF;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+uint8_t parallax_table_index(ParallaxTable *table, float parX, float parY)
+{
+    for (int i = 0; i < table->count; i++)
+    {
+        if (table->factors[i][0] == parX && table->factors[i][1] == parY)
+            return (uint8_t)i;
+    }
+    if (table->count == SPRITE_MAX_PARALLAX)
+    {
+        fprintf(stderr, "Tabella di parallasse piena, uso (%.2f, %.2f) per (%.2f, %.2f)\n",
+                table->factors[0][0], table->factors[0][1], parX, parY);
+        return 0;
+    }
+    table->factors[table->count][0] = parX;
+    table->factors[table->count][1] = parY;
+    table->dirty = 1;
+    return (uint8_t)table->count++;
+}
+
+void sprite_pack(const Sprite *sprite, ParallaxTable *parallax, PackedSprite *packed)
+{
+    float chunkX = floorf(sprite->position[0] / SPRITE_CHUNK_SIZE);
+    float chunkY = floorf(sprite->position[1] / SPRITE_CHUNK_SIZE);
+    float rotation = fmodf(sprite->rotation, 2.0f * (float)M_PI);
+    if (rotation < 0.0f)
+        rotation += 2.0f * (float)M_PI;
+
+    packed->uvStart[0] = float_to_unorm16(sprite->uvStart[0]);
+    packed->uvStart[1] = float_to_unorm16(sprite->uvStart[1]);
+    packed->uvEnd[0] = float_to_unorm16(sprite->uvEnd[0]);
+    packed->uvEnd[1] = float_to_unorm16(sprite->uvEnd[1]);
+    packed->position[0] = float_to_half(sprite->position[0] - chunkX * SPRITE_CHUNK_SIZE);
+    packed->position[1] = float_to_half(sprite->position[1] - chunkY * SPRITE_CHUNK_SIZE);
+    packed->size[0] = float_to_half(sprite->size[0]);
+    packed->size[1] = float_to_half(sprite->size[1]);
+    packed->chunk[0] = (int16_t)chunkX;
+    packed->chunk[1] = (int16_t)chunkY;
+    packed->rotation = float_to_half(rotation);
+    packed->zIndex = float_to_half(sprite->zIndex);
+    packed->layer = (uint8_t)sprite->layerIndex;
+    packed->parallax = parallax_table_index(parallax, sprite->parallaxFactorX, sprite->parallaxFactorY);
+    packed->flags = 0;
+    packed->color = (uint32_t)float_to_unorm8(sprite->color[0]) |
+                    (uint32_t)float_to_unorm8(sprite->color[1]) << 8 |
+                    (uint32_t)float_to_unorm8(sprite->color[2]) << 16 |
+                    (uint32_t)0xFFu << 24;
+}
+
+SpriteVariant sprite_variant(const Sprite *sprite)
+{
+    if (sprite->rotation != 0.0f)
+        return SPRITE_VARIANT_ROTATED;
+    if (sprite->parallaxFactorX == 1.0f && sprite->parallaxFactorY == 1.0f)
+        return SPRITE_VARIANT_NO_PARALLAX;
+    return SPRITE_VARIANT_AXIS_ALIGNED;
+}
+
 // ... other Sprite-specific function implementations ...
\ No newline at end of file
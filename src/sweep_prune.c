@@ -0,0 +1,277 @@
+#include "sweep_prune.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Oltre questi endpoint nuovi conviene riordinare tutto invece di inserirli uno a uno
+#define SWEEP_PRUNE_RESORT_THRESHOLD 32
+
+// Raddoppia la capacità di un array finché non contiene needed elementi
+static bool grow(void **array, int *capacity, int needed, size_t elementSize)
+{
+    if (needed <= *capacity)
+        return true;
+    int newCapacity = *capacity ? *capacity : 64;
+    while (newCapacity < needed)
+        newCapacity *= 2;
+    void *p = realloc(*array, (size_t)newCapacity * elementSize);
+    if (!p)
+    {
+        perror("Memory allocation failed");
+        return false;
+    }
+    *array = p;
+    *capacity = newCapacity;
+    return true;
+}
+
+static int endpoint_proxy(SweepEndpoint e)
+{
+    return (int)(e.data >> 1);
+}
+
+static bool endpoint_is_max(SweepEndpoint e)
+{
+    return e.data & 1;
+}
+
+// A parità di valore il min viene prima: le coppie che si toccano diventano candidate
+// e le scarta il test esatto, così anche un box di larghezza zero si apre prima di chiudersi
+static bool endpoint_less(SweepEndpoint a, SweepEndpoint b)
+{
+    return a.value < b.value || (a.value == b.value && (a.data & 1) < (b.data & 1));
+}
+
+static int compare_endpoints(const void *pa, const void *pb)
+{
+    SweepEndpoint a = *(const SweepEndpoint *)pa, b = *(const SweepEndpoint *)pb;
+    return endpoint_less(a, b) ? -1 : endpoint_less(b, a) ? 1 : 0;
+}
+
+static int compare_keys(const void *pa, const void *pb)
+{
+    uint64_t a = *(const uint64_t *)pa, b = *(const uint64_t *)pb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+void sweep_prune_init(SweepPrune *sap)
+{
+    memset(sap, 0, sizeof(*sap));
+}
+
+void sweep_prune_free(SweepPrune *sap)
+{
+    free(sap->proxies);
+    free(sap->freeProxies);
+    free(sap->removedProxies);
+    free(sap->endpoints);
+    free(sap->active);
+    free(sap->current);
+    free(sap->previous);
+    free(sap->pairs);
+    memset(sap, 0, sizeof(*sap));
+}
+
+int sweep_prune_add(SweepPrune *sap, float x, float y, float width, float height, uint32_t category, uint32_t mask,
+                    int user)
+{
+    if (!grow((void **)&sap->endpoints, &sap->endpointCapacity, sap->endpointCount + 2, sizeof(SweepEndpoint)))
+        return -1;
+    int proxy;
+    if (sap->freeCount > 0)
+    {
+        proxy = sap->freeProxies[--sap->freeCount];
+    }
+    else
+    {
+        if (!grow((void **)&sap->proxies, &sap->proxyCapacity, sap->proxyCount + 1, sizeof(SweepProxy)))
+            return -1;
+        proxy = sap->proxyCount++;
+    }
+
+    SweepProxy *p = &sap->proxies[proxy];
+    p->minX = x;
+    p->minY = y;
+    p->maxX = x + width;
+    p->maxY = y + height;
+    p->category = category;
+    p->mask = mask;
+    p->user = user;
+    p->activeSlot = -1;
+    p->alive = true;
+    // In coda: sweep_prune_update li porta al loro posto
+    sap->endpoints[sap->endpointCount++] = (SweepEndpoint){p->minX, (uint32_t)proxy << 1};
+    sap->endpoints[sap->endpointCount++] = (SweepEndpoint){p->maxX, (uint32_t)proxy << 1 | 1};
+    sap->addedSinceUpdate += 2;
+    return proxy;
+}
+
+void sweep_prune_remove(SweepPrune *sap, int proxy)
+{
+    if (proxy < 0 || !sap->proxies[proxy].alive)
+        return;
+    // La maniglia si ricicla solo dopo l'update che chiude le sue coppie: prima una
+    // coppia di un proxy nuovo passerebbe per PERSIST
+    if (!grow((void **)&sap->removedProxies, &sap->removedCapacity, sap->removedCount + 1, sizeof(int)))
+        return;
+    sap->proxies[proxy].alive = false;
+    sap->removedProxies[sap->removedCount++] = proxy;
+}
+
+void sweep_prune_move(SweepPrune *sap, int proxy, float x, float y, float width, float height, int user)
+{
+    SweepProxy *p = &sap->proxies[proxy];
+    p->minX = x;
+    p->minY = y;
+    p->maxX = x + width;
+    p->maxY = y + height;
+    p->user = user;
+}
+
+// Aggiorna i valori, toglie gli endpoint dei proxy rimossi e riordina
+static void sort_endpoints(SweepPrune *sap)
+{
+    int kept = 0;
+    for (int i = 0; i < sap->endpointCount; i++)
+    {
+        SweepEndpoint e = sap->endpoints[i];
+        const SweepProxy *p = &sap->proxies[endpoint_proxy(e)];
+        if (!p->alive)
+            continue;
+        e.value = endpoint_is_max(e) ? p->maxX : p->minX;
+        sap->endpoints[kept++] = e;
+    }
+    sap->endpointCount = kept;
+
+    if (sap->addedSinceUpdate > SWEEP_PRUNE_RESORT_THRESHOLD)
+    {
+        qsort(sap->endpoints, (size_t)sap->endpointCount, sizeof(SweepEndpoint), compare_endpoints);
+    }
+    else
+    {
+        // Insertion sort: con movimenti piccoli ogni endpoint si sposta di pochi posti
+        for (int i = 1; i < sap->endpointCount; i++)
+        {
+            SweepEndpoint e = sap->endpoints[i];
+            int j = i - 1;
+            while (j >= 0 && endpoint_less(e, sap->endpoints[j]))
+            {
+                sap->endpoints[j + 1] = sap->endpoints[j];
+                j--;
+            }
+            sap->endpoints[j + 1] = e;
+        }
+    }
+    sap->addedSinceUpdate = 0;
+}
+
+// Copia nella lista attiva di quello che serve al test: il ciclo interno dello sweep
+// legge memoria contigua invece di saltare tra i proxy
+typedef struct
+{
+    float minX, minY, maxX, maxY;
+    uint32_t category, mask;
+    int proxy;
+} SweepActive;
+
+static bool overlaps(const SweepProxy *a, const SweepActive *b)
+{
+    if (!(a->category & b->mask) && !(b->category & a->mask))
+        return false;
+    return a->minX < b->maxX && b->minX < a->maxX && a->minY < b->maxY && b->minY < a->maxY;
+}
+
+// Sweep lungo x: un proxy si confronta con quelli ancora aperti quando si apre il suo intervallo
+static bool sweep(SweepPrune *sap)
+{
+    if (!grow((void **)&sap->active, &sap->activeCapacity, sap->endpointCount / 2, sizeof(SweepActive)))
+        return false;
+    SweepActive *active = sap->active;
+    int activeCount = 0;
+    sap->currentCount = 0;
+    for (int i = 0; i < sap->endpointCount; i++)
+    {
+        SweepEndpoint e = sap->endpoints[i];
+        int proxy = endpoint_proxy(e);
+        SweepProxy *p = &sap->proxies[proxy];
+        if (endpoint_is_max(e))
+        {
+            active[p->activeSlot] = active[--activeCount];
+            sap->proxies[active[p->activeSlot].proxy].activeSlot = p->activeSlot;
+            p->activeSlot = -1;
+            continue;
+        }
+        for (int k = 0; k < activeCount; k++)
+        {
+            if (!overlaps(p, &active[k]))
+                continue;
+            if (!grow((void **)&sap->current, &sap->currentCapacity, sap->currentCount + 1, sizeof(uint64_t)))
+                return false;
+            int other = active[k].proxy;
+            int a = proxy < other ? proxy : other, b = proxy < other ? other : proxy;
+            sap->current[sap->currentCount++] = (uint64_t)a << 32 | (uint32_t)b;
+        }
+        p->activeSlot = activeCount;
+        active[activeCount++] = (SweepActive){p->minX, p->minY, p->maxX, p->maxY, p->category, p->mask, proxy};
+    }
+    return true;
+}
+
+static bool emit(SweepPrune *sap, uint64_t key, SweepPairState state)
+{
+    if (!grow((void **)&sap->pairs, &sap->pairCapacity, sap->pairCount + 1, sizeof(SweepPair)))
+        return false;
+    sap->pairs[sap->pairCount++] = (SweepPair){(int)(key >> 32), (int)(uint32_t)key, state};
+    return true;
+}
+
+bool sweep_prune_update(SweepPrune *sap)
+{
+    sort_endpoints(sap);
+    if (!sweep(sap))
+        return false;
+    qsort(sap->current, (size_t)sap->currentCount, sizeof(uint64_t), compare_keys);
+
+    // Fusione di due liste ordinate: solo nella nuova BEGIN, in entrambe PERSIST, solo nella vecchia END
+    sap->pairCount = 0;
+    int i = 0, j = 0;
+    while (i < sap->currentCount || j < sap->previousCount)
+    {
+        bool ok;
+        if (j == sap->previousCount || (i < sap->currentCount && sap->current[i] < sap->previous[j]))
+            ok = emit(sap, sap->current[i++], SWEEP_PAIR_BEGIN);
+        else if (i == sap->currentCount || sap->previous[j] < sap->current[i])
+            ok = emit(sap, sap->previous[j++], SWEEP_PAIR_END);
+        else
+        {
+            ok = emit(sap, sap->current[i++], SWEEP_PAIR_PERSIST);
+            j++;
+        }
+        if (!ok)
+            return false;
+    }
+
+    // Le coppie correnti diventano le vecchie; lo scambio riusa le due allocazioni
+    uint64_t *swap = sap->previous;
+    int swapCapacity = sap->previousCapacity;
+    sap->previous = sap->current;
+    sap->previousCapacity = sap->currentCapacity;
+    sap->previousCount = sap->currentCount;
+    sap->current = swap;
+    sap->currentCapacity = swapCapacity;
+    sap->currentCount = 0;
+
+    // Le END dei proxy rimossi sono state emesse: ora le maniglie si possono riusare
+    if (!grow((void **)&sap->freeProxies, &sap->freeCapacity, sap->freeCount + sap->removedCount, sizeof(int)))
+        return false;
+    memcpy(sap->freeProxies + sap->freeCount, sap->removedProxies, (size_t)sap->removedCount * sizeof(int));
+    sap->freeCount += sap->removedCount;
+    sap->removedCount = 0;
+    return true;
+}
+
+const SweepPair *sweep_prune_pairs(const SweepPrune *sap, int *count)
+{
+    *count = sap->pairCount;
+    return sap->pairs;
+}
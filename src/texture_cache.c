@@ -0,0 +1,169 @@
+#include "texture_cache.h"
+#include "hash.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(TextureCacheHeader) == 48, "il formato della cache assume un header da 48 byte");
+
+uint64_t texture_cache_hash(const void *data, size_t size)
+{
+    return hash_fnv1a(HASH_FNV1A_SEED, data, size);
+}
+
+size_t texture_cache_chain_size(int width, int height, int mipLevels)
+{
+    size_t size = 0;
+    for (int level = 0; level < mipLevels; level++)
+    {
+        size += (size_t)width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+// "./assets/textures/0.png" -> "assets/cache/assets_textures_0.png.tex"
+static void cache_path(const char *sourcePath, char *out, size_t size)
+{
+    while (sourcePath[0] == '.' && sourcePath[1] == '/')
+        sourcePath += 2;
+    int n = snprintf(out, size, "%s/", TEXTURE_CACHE_DIR);
+    for (const char *c = sourcePath; *c && (size_t)n + 5 < size; c++)
+        out[n++] = *c == '/' ? '_' : *c;
+    snprintf(out + n, size - n, ".tex");
+}
+
+static int64_t stat_mtime(const struct stat *st)
+{
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+// Hash del PNG sorgente, solo quando dimensione e mtime non bastano a decidere
+static bool hash_file(const char *path, uint64_t *hash)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = malloc(size > 0 ? size : 1);
+    bool ok = data && fread(data, 1, size, file) == (size_t)size;
+    if (ok)
+        *hash = texture_cache_hash(data, size);
+    free(data);
+    fclose(file);
+    return ok;
+}
+
+bool texture_cache_open(const char *sourcePath, TextureCacheEntry *entry)
+{
+    memset(entry, 0, sizeof(*entry));
+    struct stat source;
+    if (stat(sourcePath, &source) != 0)
+        return false;
+
+    char path[512];
+    cache_path(sourcePath, path, sizeof(path));
+    int fd = open(path, O_RDWR);
+    if (fd < 0)
+        return false; // nessuna cache: la si scrive dopo la decodifica
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TextureCacheHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+    TextureCacheHeader header;
+    memcpy(&header, mapping, sizeof(header));
+
+    bool valid = header.magic == TEXTURE_CACHE_MAGIC && header.version == TEXTURE_CACHE_VERSION &&
+                 header.sourceSize == (uint64_t)source.st_size &&
+                 (size_t)st.st_size == sizeof(header) + texture_cache_chain_size(header.width, header.height, header.mipLevels);
+    if (valid && header.sourceMtime != stat_mtime(&source))
+    {
+        // Stesso contenuto con un mtime diverso: si aggiorna l'header per il prossimo avvio
+        uint64_t hash;
+        valid = hash_file(sourcePath, &hash) && hash == header.sourceHash;
+        if (valid)
+        {
+            header.sourceMtime = stat_mtime(&source);
+            if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+                fprintf(stderr, "Impossibile aggiornare la cache %s\n", path);
+        }
+    }
+    close(fd);
+    if (!valid)
+    {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+
+    entry->header = header;
+    entry->pixels = (const unsigned char *)mapping + sizeof(header);
+    entry->mapping = mapping;
+    entry->mappingSize = st.st_size;
+    return true;
+}
+
+void texture_cache_close(TextureCacheEntry *entry)
+{
+    if (entry->mapping)
+        munmap(entry->mapping, entry->mappingSize);
+    memset(entry, 0, sizeof(*entry));
+}
+
+bool texture_cache_write(const char *sourcePath, uint64_t sourceHash, const TextureCacheHeader *layout,
+                         const unsigned char *pixels)
+{
+    struct stat source;
+    if (stat(sourcePath, &source) != 0)
+        return false;
+    if (mkdir(TEXTURE_CACHE_DIR, 0755) != 0 && errno != EEXIST)
+    {
+        perror(TEXTURE_CACHE_DIR);
+        return false;
+    }
+
+    TextureCacheHeader header = *layout;
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.sourceMtime = stat_mtime(&source);
+    header.sourceSize = source.st_size;
+
+    // Si scrive su un file temporaneo e lo si rinomina: chi legge vede la vecchia cache o la nuova
+    char path[512], tmpPath[528];
+    cache_path(sourcePath, path, sizeof(path));
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d.tmp", path, (int)getpid());
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file)
+    {
+        perror("Failed to open file");
+        return false;
+    }
+    size_t chainSize = texture_cache_chain_size(header.width, header.height, header.mipLevels);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(pixels, 1, chainSize, file) == chainSize;
+    if (fclose(file) != 0)
+        ok = false;
+    if (!ok || rename(tmpPath, path) != 0)
+    {
+        fprintf(stderr, "Impossibile scrivere la cache %s\n", path);
+        remove(tmpPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,266 @@
+#include "texture_loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// Tempo di CPU consumato dal thread chiamante: un worker fermo su I/O o senza core non conta
+static long long thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int texture_loader_mip_levels(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        levels++;
+    }
+    return levels;
+}
+
+// Ogni livello è la media 2x2 del precedente (sui lati dispari l'ultimo texel si ripete),
+// fatta con i colori premoltiplicati per alpha: un texel trasparente non scurisce i vicini
+static void build_mips(unsigned char *chain, int width, int height, int mipLevels)
+{
+    unsigned char *src = chain;
+    for (int level = 1; level < mipLevels; level++)
+    {
+        int w = width > 1 ? width / 2 : 1;
+        int h = height > 1 ? height / 2 : 1;
+        unsigned char *dst = src + (size_t)width * height * 4;
+        for (int y = 0; y < h; y++)
+        {
+            int y0 = y * 2, y1 = y * 2 + 1 < height ? y * 2 + 1 : y * 2;
+            for (int x = 0; x < w; x++)
+            {
+                int x0 = x * 2, x1 = x * 2 + 1 < width ? x * 2 + 1 : x * 2;
+                const unsigned char *texels[4] = {&src[((size_t)y0 * width + x0) * 4], &src[((size_t)y0 * width + x1) * 4],
+                                                  &src[((size_t)y1 * width + x0) * 4], &src[((size_t)y1 * width + x1) * 4]};
+                int alpha = 0, color[3] = {0, 0, 0};
+                for (int t = 0; t < 4; t++)
+                {
+                    alpha += texels[t][3];
+                    for (int c = 0; c < 3; c++)
+                        color[c] += texels[t][c] * texels[t][3];
+                }
+                // Di nuovo alpha dritto, come lo legge sprite.frag; tutto trasparente resta nero
+                unsigned char *out = &dst[((size_t)y * w + x) * 4];
+                for (int c = 0; c < 3; c++)
+                    out[c] = alpha ? (unsigned char)((color[c] + alpha / 2) / alpha) : 0;
+                out[3] = (unsigned char)((alpha + 2) / 4);
+            }
+        }
+        src = dst;
+        width = w;
+        height = h;
+    }
+}
+
+// Livelli della catena di un layer: completa, o fino a mipLimit se il chiamante lo chiede
+static int layer_mip_levels(const TextureLayer *layer, int width, int height)
+{
+    int levels = texture_loader_mip_levels(width, height);
+    return layer->mipLimit > 0 && levels > layer->mipLimit ? layer->mipLimit : levels;
+}
+
+static bool load_from_cache(TextureLayer *layer)
+{
+    if (!texture_cache_open(layer->path, &layer->cache))
+        return false;
+    const TextureCacheHeader *header = &layer->cache.header;
+    if ((int)header->mipLevels != layer_mip_levels(layer, (int)header->width, (int)header->height))
+    {
+        // Catena di un'altra lunghezza (l'atlas ha cambiato padding): si decodifica di nuovo
+        texture_cache_close(&layer->cache);
+        return false;
+    }
+    layer->pixels = layer->cache.pixels;
+    layer->width = (int)layer->cache.header.width;
+    layer->height = (int)layer->cache.header.height;
+    layer->mipLevels = (int)layer->cache.header.mipLevels;
+    layer->translucent = layer->cache.header.translucent != 0;
+    return true;
+}
+
+static void decode_layer(TextureLayer *layer)
+{
+    layer->translucent = true;
+    FILE *file = fopen(layer->path, "rb");
+    if (!file)
+        return;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = malloc(size > 0 ? size : 1);
+    bool ok = data && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    int channels;
+    unsigned char *image = ok ? stbi_load_from_memory(data, (int)size, &layer->width, &layer->height, &channels, STBI_rgb_alpha) : NULL;
+    if (!image)
+    {
+        free(data);
+        return;
+    }
+
+    layer->mipLevels = layer_mip_levels(layer, layer->width, layer->height);
+    unsigned char *chain = malloc(texture_cache_chain_size(layer->width, layer->height, layer->mipLevels));
+    if (!chain)
+    {
+        perror("Memory allocation failed");
+        stbi_image_free(image);
+        free(data);
+        return;
+    }
+    size_t texels = (size_t)layer->width * layer->height;
+    memcpy(chain, image, texels * 4);
+    stbi_image_free(image);
+    build_mips(chain, layer->width, layer->height, layer->mipLevels);
+
+    // Un layer con anche un solo texel non opaco va nella passata traslucida
+    layer->translucent = false;
+    for (size_t p = 0; p < texels; p++)
+    {
+        if (chain[p * 4 + 3] != 255)
+        {
+            layer->translucent = true;
+            break;
+        }
+    }
+    layer->pixels = chain;
+
+    TextureCacheHeader layout = {0};
+    layout.width = (uint32_t)layer->width;
+    layout.height = (uint32_t)layer->height;
+    layout.mipLevels = (uint32_t)layer->mipLevels;
+    layout.translucent = layer->translucent;
+    texture_cache_write(layer->path, texture_cache_hash(data, size), &layout, chain);
+    free(data);
+}
+
+bool texture_layer_load(TextureLayer *layer)
+{
+    if (!load_from_cache(layer))
+        decode_layer(layer);
+    return layer->pixels != NULL;
+}
+
+void texture_layer_free(TextureLayer *layer)
+{
+    if (layer->cache.mapping)
+        texture_cache_close(&layer->cache);
+    else
+        free((void *)layer->pixels);
+    layer->pixels = NULL;
+}
+
+static void *decode_worker(void *arg)
+{
+    TextureLoader *loader = arg;
+    for (;;)
+    {
+        int i = atomic_fetch_add(&loader->nextLayer, 1);
+        if (i >= loader->layerCount)
+            break;
+
+        long long cpuStart = thread_cpu_ns();
+        texture_layer_load(&loader->layers[i]);
+        if (loader->layers[i].cache.mapping)
+            atomic_fetch_add(&loader->cacheHits, 1);
+        atomic_fetch_add(&loader->decodeCpuNs, thread_cpu_ns() - cpuStart);
+        double end = clock_now_ms();
+        if (atomic_fetch_sub(&loader->pending, 1) == 1)
+            loader->decodeWallMs = end - loader->startTime; // ultimo layer: letto solo dopo il join
+    }
+    return NULL;
+}
+
+void texture_loader_start(TextureLoader *loader, int threads)
+{
+    memset(loader, 0, sizeof(*loader));
+    loader->startTime = clock_now_ms();
+
+    // Se c'è un atlas impacchettato da tools/atlas_pack i layer vengono dal suo manifest,
+    // altrimenti si ripiega sulle vecchie texture 512x512 numerate.
+    loader->width = 512;
+    loader->height = 512;
+    loader->layerCount = 4;
+    loader->useAtlas = atlas_load(&loader->atlas, ATLAS_DEFAULT_PATH) && loader->atlas.layerCount > 0;
+    if (loader->useAtlas)
+    {
+        loader->width = (int)loader->atlas.layerWidth;
+        loader->height = (int)loader->atlas.layerHeight;
+        loader->layerCount = (int)loader->atlas.layerCount;
+        if (loader->layerCount > TEXTURE_LOADER_MAX_LAYERS)
+        {
+            fprintf(stderr, "Atlas con %d layer, il renderer ne gestisce %d\n", loader->layerCount, TEXTURE_LOADER_MAX_LAYERS);
+            loader->layerCount = TEXTURE_LOADER_MAX_LAYERS;
+        }
+    }
+    // Le pagine dell'atlas hanno solo i livelli che il padding protegge dal bleeding
+    int mipLimit = loader->useAtlas ? atlas_mip_levels(&loader->atlas) : 0;
+    loader->mipLevels = texture_loader_mip_levels(loader->width, loader->height);
+    if (mipLimit > 0 && loader->mipLevels > mipLimit)
+        loader->mipLevels = mipLimit;
+    for (int i = 0; i < loader->layerCount; i++)
+    {
+        loader->layers[i].mipLimit = mipLimit;
+        if (loader->useAtlas)
+            atlas_layer_path(ATLAS_DEFAULT_PATH, i, loader->layers[i].path, sizeof(loader->layers[i].path));
+        else
+            sprintf(loader->layers[i].path, "./assets/textures/%d.png", i);
+    }
+
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > TEXTURE_LOADER_MAX_THREADS)
+        threads = TEXTURE_LOADER_MAX_THREADS;
+    if (threads > loader->layerCount)
+        threads = loader->layerCount;
+    atomic_init(&loader->nextLayer, 0);
+    atomic_init(&loader->pending, loader->layerCount);
+    atomic_init(&loader->decodeCpuNs, 0);
+    atomic_init(&loader->cacheHits, 0);
+
+    for (int t = 0; t < threads; t++)
+    {
+        if (pthread_create(&loader->threads[t], NULL, decode_worker, loader) != 0)
+        {
+            fprintf(stderr, "Impossibile creare il thread di decodifica %d\n", t);
+            break;
+        }
+        loader->threadCount++;
+    }
+    // Senza thread si decodifica qui: texture_loader_wait troverà tutto pronto
+    if (loader->threadCount == 0)
+        decode_worker(loader);
+}
+
+void texture_loader_wait(TextureLoader *loader)
+{
+    double start = clock_now_ms();
+    for (int t = 0; t < loader->threadCount; t++)
+    {
+        pthread_join(loader->threads[t], NULL);
+    }
+    loader->threadCount = 0;
+    loader->waitMs += clock_now_ms() - start;
+}
+
+void texture_loader_free(TextureLoader *loader)
+{
+    texture_loader_wait(loader);
+    for (int i = 0; i < loader->layerCount; i++)
+    {
+        texture_layer_free(&loader->layers[i]);
+    }
+    atlas_free(&loader->atlas);
+}
@@ -0,0 +1,113 @@
+#include "texture_residency.h"
+#include <stdio.h>
+#include <string.h>
+
+void texture_residency_init(TextureResidency *residency, int slotCount)
+{
+    memset(residency, 0, sizeof(*residency));
+    if (slotCount > TEXTURE_RESIDENCY_MAX_LAYERS)
+        slotCount = TEXTURE_RESIDENCY_MAX_LAYERS;
+    residency->slotCount = slotCount;
+    for (int i = 0; i < TEXTURE_RESIDENCY_MAX_LAYERS; i++)
+    {
+        residency->slotOf[i] = TEXTURE_RESIDENCY_NONE;
+        residency->layerOf[i] = TEXTURE_RESIDENCY_NONE;
+    }
+    residency->changed = true;
+}
+
+void texture_residency_set_path(TextureResidency *residency, int layer, const char *path)
+{
+    if (layer < 0 || layer >= TEXTURE_RESIDENCY_MAX_LAYERS)
+        return;
+    snprintf(residency->paths[layer], sizeof(residency->paths[layer]), "%s", path);
+    residency->failed &= ~(1ull << layer);
+    if (layer >= residency->layerCount)
+        residency->layerCount = layer + 1;
+}
+
+void texture_residency_touch(TextureResidency *residency, uint64_t referenced)
+{
+    residency->frame++;
+    for (int slot = 0; slot < residency->slotCount; slot++)
+    {
+        int layer = residency->layerOf[slot];
+        if (layer != TEXTURE_RESIDENCY_NONE && (referenced >> layer & 1))
+            residency->lastUsed[slot] = residency->frame;
+    }
+}
+
+int texture_residency_acquire(TextureResidency *residency, int layer, uint64_t referenced)
+{
+    // Un layer già residente si ricarica nel suo slot e resta visibile fino all'upload
+    int best = residency->slotOf[layer];
+    if (best != TEXTURE_RESIDENCY_NONE)
+    {
+        residency->lastUsed[best] = residency->frame;
+        residency->loading |= 1ull << layer;
+        return best;
+    }
+    for (int slot = 0; slot < residency->slotCount; slot++)
+    {
+        int current = residency->layerOf[slot];
+        if (current == TEXTURE_RESIDENCY_NONE)
+        {
+            best = slot;
+            break;
+        }
+        // Non si sfrattano i layer che servono a questo frame né quelli in caricamento
+        if ((referenced >> current & 1) || (residency->loading >> current & 1))
+            continue;
+        if (best == TEXTURE_RESIDENCY_NONE || residency->lastUsed[slot] < residency->lastUsed[best])
+            best = slot;
+    }
+    if (best == TEXTURE_RESIDENCY_NONE)
+        return TEXTURE_RESIDENCY_NONE;
+
+    int evicted = residency->layerOf[best];
+    if (evicted != TEXTURE_RESIDENCY_NONE)
+    {
+        residency->slotOf[evicted] = TEXTURE_RESIDENCY_NONE;
+        residency->changed = true;
+    }
+    residency->layerOf[best] = layer;
+    residency->lastUsed[best] = residency->frame;
+    residency->loading |= 1ull << layer;
+    return best;
+}
+
+void texture_residency_loaded(TextureResidency *residency, int slot, bool ok)
+{
+    int layer = residency->layerOf[slot];
+    if (layer == TEXTURE_RESIDENCY_NONE)
+        return;
+    residency->loading &= ~(1ull << layer);
+    if (ok)
+    {
+        residency->slotOf[layer] = slot;
+    }
+    else if (residency->slotOf[layer] != slot)
+    {
+        // Lo slot torna libero; una ricarica fallita invece lascia residente il vecchio contenuto
+        residency->layerOf[slot] = TEXTURE_RESIDENCY_NONE;
+        residency->failed |= 1ull << layer;
+    }
+    residency->changed = true;
+}
+
+void texture_residency_cancel(TextureResidency *residency, int slot)
+{
+    int layer = residency->layerOf[slot];
+    if (layer == TEXTURE_RESIDENCY_NONE)
+        return;
+    residency->loading &= ~(1ull << layer);
+    if (residency->slotOf[layer] != slot)
+        residency->layerOf[slot] = TEXTURE_RESIDENCY_NONE;
+}
+
+bool texture_residency_missing(const TextureResidency *residency, int layer)
+{
+    uint64_t bit = 1ull << layer;
+    return layer < residency->layerCount && residency->paths[layer][0] &&
+           residency->slotOf[layer] == TEXTURE_RESIDENCY_NONE && !(residency->loading & bit) && !(residency->failed & bit);
+}
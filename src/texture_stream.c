@@ -0,0 +1,244 @@
+#include "texture_stream.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+#include <stdio.h>
+#include <string.h>
+
+static int find_free_slot(const TextureStream *stream)
+{
+    for (int i = 0; i < TEXTURE_STREAM_SLOTS; i++)
+    {
+        if (stream->slots[i].state == TEXTURE_SLOT_FREE)
+            return i;
+    }
+    return -1;
+}
+
+// Prende una richiesta appena c'è uno slot libero, la decodifica fuori dal lock
+// direttamente nel buffer mappato e lascia lo slot pronto per l'upload
+static void *stream_worker(void *arg)
+{
+    TextureStream *stream = arg;
+    pthread_mutex_lock(&stream->mutex);
+    for (;;)
+    {
+        int s = -1;
+        while (!stream->quit && (stream->queueCount == 0 || (s = find_free_slot(stream)) < 0))
+            pthread_cond_wait(&stream->wake, &stream->mutex);
+        if (stream->quit)
+            break;
+
+        TextureStreamSlot *slot = &stream->slots[s];
+        slot->request = stream->queue[stream->queueHead];
+        stream->queueHead = (stream->queueHead + 1) % TEXTURE_STREAM_MAX_REQUESTS;
+        stream->queueCount--;
+        slot->state = TEXTURE_SLOT_DECODING;
+        pthread_mutex_unlock(&stream->mutex);
+
+        TextureLayer layer;
+        memset(&layer, 0, sizeof(layer));
+        snprintf(layer.path, sizeof(layer.path), "%s", slot->request.path);
+        layer.mipLimit = stream->mipLevels; // quanti ne ha la texture array
+        bool ok = texture_layer_load(&layer);
+        if (ok && (layer.width != stream->width || layer.height != stream->height || layer.mipLevels != stream->mipLevels))
+        {
+            fprintf(stderr, "Texture %s: %dx%d invece di %dx%d\n", layer.path, layer.width, layer.height,
+                    stream->width, stream->height);
+            ok = false;
+        }
+        if (ok)
+            memcpy(slot->mapped, layer.pixels, stream->chainSize);
+        slot->translucent = layer.translucent;
+        texture_layer_free(&layer);
+
+        pthread_mutex_lock(&stream->mutex);
+        slot->ok = ok;
+        slot->state = TEXTURE_SLOT_READY;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return NULL;
+}
+
+bool texture_stream_init(TextureStream *stream, GLuint textureArray, int width, int height, int mipLevels,
+                         int layerCount)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->textureArray = textureArray;
+    stream->width = width;
+    stream->height = height;
+    stream->mipLevels = mipLevels;
+    stream->layerCount = layerCount;
+    stream->chainSize = texture_cache_chain_size(width, height, mipLevels);
+    if (!GLAD_GL_ARB_buffer_storage)
+    {
+        fprintf(stderr, "GL_ARB_buffer_storage non supportato: streaming delle texture disattivato\n");
+        return false;
+    }
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (int i = 0; i < TEXTURE_STREAM_SLOTS; i++)
+    {
+        TextureStreamSlot *slot = &stream->slots[i];
+        glGenBuffers(1, &slot->buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)stream->chainSize, NULL, flags);
+        slot->mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)stream->chainSize, flags);
+        if (!slot->mapped)
+        {
+            fprintf(stderr, "Impossibile mappare il buffer di staging %d delle texture\n", i);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            texture_stream_free(stream);
+            return false;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->wake, NULL);
+    for (int t = 0; t < TEXTURE_STREAM_THREADS; t++)
+    {
+        if (pthread_create(&stream->threads[t], NULL, stream_worker, stream) != 0)
+            break;
+        stream->threadCount++;
+    }
+    if (stream->threadCount == 0)
+    {
+        fprintf(stderr, "Impossibile creare i thread di streaming delle texture\n");
+        pthread_cond_destroy(&stream->wake);
+        pthread_mutex_destroy(&stream->mutex);
+        texture_stream_free(stream);
+        return false;
+    }
+    return true;
+}
+
+bool texture_stream_request(TextureStream *stream, int layer, const char *path, TextureStreamCallback callback, void *user)
+{
+    if (stream->threadCount == 0 || layer < 0 || layer >= stream->layerCount)
+        return false;
+
+    pthread_mutex_lock(&stream->mutex);
+    bool queued = stream->queueCount < TEXTURE_STREAM_MAX_REQUESTS;
+    if (queued)
+    {
+        TextureStreamRequest *request = &stream->queue[(stream->queueHead + stream->queueCount) % TEXTURE_STREAM_MAX_REQUESTS];
+        snprintf(request->path, sizeof(request->path), "%s", path);
+        request->layer = layer;
+        request->callback = callback;
+        request->user = user;
+        stream->queueCount++;
+        pthread_cond_signal(&stream->wake);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return queued;
+}
+
+void texture_stream_update(TextureStream *stream)
+{
+    if (stream->threadCount == 0)
+        return;
+
+    // Le callback si chiamano fuori dal lock: possono accodare altre richieste
+    TextureStreamRequest done[TEXTURE_STREAM_SLOTS];
+    bool doneOk[TEXTURE_STREAM_SLOTS], doneTranslucent[TEXTURE_STREAM_SLOTS];
+    int doneCount = 0;
+
+    pthread_mutex_lock(&stream->mutex);
+    for (int i = 0; i < TEXTURE_STREAM_SLOTS; i++)
+    {
+        TextureStreamSlot *slot = &stream->slots[i];
+        if (slot->state == TEXTURE_SLOT_READY && slot->ok)
+        {
+            // Sorgente nel buffer: la chiamata ritorna subito, la copia la fa il driver
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, stream->textureArray);
+            size_t offset = 0;
+            int levelWidth = stream->width, levelHeight = stream->height;
+            for (int level = 0; level < stream->mipLevels; level++)
+            {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, slot->request.layer, levelWidth, levelHeight, 1,
+                                GL_RGBA, GL_UNSIGNED_BYTE, (const void *)offset);
+                offset += (size_t)levelWidth * levelHeight * 4;
+                levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+                levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+            }
+            slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot->state = TEXTURE_SLOT_UPLOADING;
+        }
+        else if (slot->state == TEXTURE_SLOT_READY)
+        {
+            done[doneCount] = slot->request;
+            doneTranslucent[doneCount] = true;
+            doneOk[doneCount++] = false;
+            slot->state = TEXTURE_SLOT_FREE;
+            pthread_cond_signal(&stream->wake);
+        }
+        else if (slot->state == TEXTURE_SLOT_UPLOADING)
+        {
+            GLenum result = glClientWaitSync(slot->fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                glDeleteSync(slot->fence);
+                slot->fence = 0;
+                done[doneCount] = slot->request;
+                doneTranslucent[doneCount] = slot->translucent;
+                doneOk[doneCount++] = true;
+                slot->state = TEXTURE_SLOT_FREE;
+                pthread_cond_signal(&stream->wake);
+            }
+        }
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    for (int i = 0; i < doneCount; i++)
+    {
+        if (done[i].callback)
+            done[i].callback(done[i].user, done[i].layer, doneOk[i], doneTranslucent[i]);
+    }
+}
+
+bool texture_stream_idle(TextureStream *stream)
+{
+    if (stream->threadCount == 0)
+        return true;
+    pthread_mutex_lock(&stream->mutex);
+    bool idle = stream->queueCount == 0;
+    for (int i = 0; idle && i < TEXTURE_STREAM_SLOTS; i++)
+        idle = stream->slots[i].state == TEXTURE_SLOT_FREE;
+    pthread_mutex_unlock(&stream->mutex);
+    return idle;
+}
+
+void texture_stream_free(TextureStream *stream)
+{
+    if (stream->threadCount)
+    {
+        pthread_mutex_lock(&stream->mutex);
+        stream->quit = true;
+        pthread_cond_broadcast(&stream->wake);
+        pthread_mutex_unlock(&stream->mutex);
+        for (int t = 0; t < stream->threadCount; t++)
+        {
+            pthread_join(stream->threads[t], NULL);
+        }
+        stream->threadCount = 0;
+        pthread_cond_destroy(&stream->wake);
+        pthread_mutex_destroy(&stream->mutex);
+    }
+    for (int i = 0; i < TEXTURE_STREAM_SLOTS; i++)
+    {
+        TextureStreamSlot *slot = &stream->slots[i];
+        if (slot->fence)
+            glDeleteSync(slot->fence);
+        if (slot->buffer)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+            if (slot->mapped)
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &slot->buffer);
+        }
+    }
+    memset(stream->slots, 0, sizeof(stream->slots));
+}
@@ -0,0 +1,101 @@
+#include "tilemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void mark_dirty(TileMap *map, int x0, int y0, int x1, int y1)
+{
+    if (map->dirtyX0 >= map->dirtyX1 || map->dirtyY0 >= map->dirtyY1)
+    {
+        map->dirtyX0 = x0;
+        map->dirtyY0 = y0;
+        map->dirtyX1 = x1;
+        map->dirtyY1 = y1;
+        return;
+    }
+    if (x0 < map->dirtyX0)
+        map->dirtyX0 = x0;
+    if (y0 < map->dirtyY0)
+        map->dirtyY0 = y0;
+    if (x1 > map->dirtyX1)
+        map->dirtyX1 = x1;
+    if (y1 > map->dirtyY1)
+        map->dirtyY1 = y1;
+}
+
+bool tilemap_init(TileMap *map, int width, int height, int tilesetLayer, int tilesetColumns, float zIndex)
+{
+    memset(map, 0, sizeof(*map));
+    map->width = width;
+    map->height = height;
+    map->chunksX = (width + TILEMAP_CHUNK_TILES - 1) / TILEMAP_CHUNK_TILES;
+    map->chunksY = (height + TILEMAP_CHUNK_TILES - 1) / TILEMAP_CHUNK_TILES;
+    map->tilesetLayer = tilesetLayer;
+    map->tilesetColumns = tilesetColumns;
+    map->zIndex = zIndex;
+
+    map->tiles = calloc((size_t)width * height, sizeof(uint16_t));
+    map->chunkTiles = calloc((size_t)map->chunksX * map->chunksY, sizeof(uint16_t));
+    if (!map->tiles || !map->chunkTiles)
+    {
+        perror("Memory allocation failed");
+        tilemap_free(map);
+        return false;
+    }
+    // La texture degli indici va caricata tutta la prima volta
+    mark_dirty(map, 0, 0, width, height);
+    return true;
+}
+
+void tilemap_free(TileMap *map)
+{
+    free(map->tiles);
+    free(map->chunkTiles);
+    map->tiles = NULL;
+    map->chunkTiles = NULL;
+    // Una mappa liberata (anche da un tilemap_init fallito) è vuota, non grande e senza dati
+    map->width = map->height = 0;
+    map->chunksX = map->chunksY = 0;
+    map->dirtyX0 = map->dirtyY0 = map->dirtyX1 = map->dirtyY1 = 0;
+}
+
+void tilemap_set(TileMap *map, int x, int y, uint16_t tile)
+{
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+        return;
+
+    uint16_t *cell = &map->tiles[(size_t)y * map->width + x];
+    if (*cell == tile)
+        return;
+
+    uint16_t *chunk = &map->chunkTiles[(y / TILEMAP_CHUNK_TILES) * map->chunksX + x / TILEMAP_CHUNK_TILES];
+    if (*cell == TILEMAP_EMPTY)
+        (*chunk)++;
+    else if (tile == TILEMAP_EMPTY)
+        (*chunk)--;
+    *cell = tile;
+    mark_dirty(map, x, y, x + 1, y + 1);
+}
+
+uint16_t tilemap_get(const TileMap *map, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+        return TILEMAP_EMPTY;
+    return map->tiles[(size_t)y * map->width + x];
+}
+
+void tilemap_fill(TileMap *map, int x0, int y0, int x1, int y1, uint16_t tile)
+{
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = x0; x < x1; x++)
+        {
+            tilemap_set(map, x, y, tile);
+        }
+    }
+}
+
+bool tilemap_chunk_empty(const TileMap *map, int chunkX, int chunkY)
+{
+    return map->chunkTiles[chunkY * map->chunksX + chunkX] == 0;
+}
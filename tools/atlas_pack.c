@@ -0,0 +1,500 @@
+// atlas_pack: impacchetta PNG sciolti nei layer della texture array.
+//
+//   atlas_pack [-o dir] [-s layer_size] [-p padding] sprite.png ...
+//
+// Scrive dir/atlas.bin (manifest binario letto da renderer_init, vedi atlas.h),
+// dir/layer_N.png e dir/atlas.json per l'editor. Il nome di ogni regione è il nome
+// del file senza estensione. Packer MaxRects (best short side fit) su più layer.
+#include "atlas.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+typedef struct
+{
+    int x, y, width, height;
+} Rect;
+
+// Spazio libero di un layer: rettangoli massimali, anche sovrapposti
+typedef struct
+{
+    Rect *free;
+    size_t count, capacity;
+} MaxRects;
+
+typedef struct
+{
+    const char *path;
+    char name[ATLAS_NAME_LENGTH];
+    unsigned char *pixels; // RGBA8
+    int width, height;
+} Image;
+
+static void maxrects_push(MaxRects *bin, Rect rect)
+{
+    if (bin->count == bin->capacity)
+    {
+        bin->capacity = bin->capacity ? bin->capacity * 2 : 64;
+        bin->free = realloc(bin->free, bin->capacity * sizeof(Rect));
+        if (!bin->free)
+        {
+            perror("Memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    bin->free[bin->count++] = rect;
+}
+
+static void maxrects_init(MaxRects *bin, int width, int height)
+{
+    memset(bin, 0, sizeof(*bin));
+    maxrects_push(bin, (Rect){0, 0, width, height});
+}
+
+// Best short side fit: lo spazio avanzato sul lato corto più piccolo, poi sul lato lungo.
+// Restituisce 0 se il rettangolo non entra.
+static int maxrects_find(const MaxRects *bin, int width, int height, Rect *best, long *shortScore, long *longScore)
+{
+    int found = 0;
+    for (size_t i = 0; i < bin->count; i++)
+    {
+        const Rect *f = &bin->free[i];
+        if (f->width < width || f->height < height)
+            continue;
+        int leftX = f->width - width;
+        int leftY = f->height - height;
+        long shortSide = leftX < leftY ? leftX : leftY;
+        long longSide = leftX < leftY ? leftY : leftX;
+        if (!found || shortSide < *shortScore || (shortSide == *shortScore && longSide < *longScore))
+        {
+            *best = (Rect){f->x, f->y, width, height};
+            *shortScore = shortSide;
+            *longScore = longSide;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+static int contains(const Rect *outer, const Rect *inner)
+{
+    return inner->x >= outer->x && inner->y >= outer->y &&
+           inner->x + inner->width <= outer->x + outer->width &&
+           inner->y + inner->height <= outer->y + outer->height;
+}
+
+static void maxrects_place(MaxRects *bin, const Rect *used)
+{
+    // Ogni rettangolo libero che interseca quello usato si divide nei (fino a) 4 massimali rimasti
+    size_t count = bin->count;
+    for (size_t i = 0; i < count;)
+    {
+        Rect f = bin->free[i];
+        if (used->x >= f.x + f.width || used->x + used->width <= f.x ||
+            used->y >= f.y + f.height || used->y + used->height <= f.y)
+        {
+            i++;
+            continue;
+        }
+        bin->free[i] = bin->free[--count];
+        bin->free[count] = bin->free[--bin->count];
+
+        if (used->x > f.x)
+            maxrects_push(bin, (Rect){f.x, f.y, used->x - f.x, f.height});
+        if (used->x + used->width < f.x + f.width)
+            maxrects_push(bin, (Rect){used->x + used->width, f.y, f.x + f.width - used->x - used->width, f.height});
+        if (used->y > f.y)
+            maxrects_push(bin, (Rect){f.x, f.y, f.width, used->y - f.y});
+        if (used->y + used->height < f.y + f.height)
+            maxrects_push(bin, (Rect){f.x, used->y + used->height, f.width, f.y + f.height - used->y - used->height});
+    }
+
+    // Via i rettangoli contenuti in altri
+    for (size_t i = 0; i < bin->count; i++)
+    {
+        for (size_t j = i + 1; j < bin->count;)
+        {
+            if (contains(&bin->free[i], &bin->free[j]))
+            {
+                bin->free[j] = bin->free[--bin->count];
+            }
+            else if (contains(&bin->free[j], &bin->free[i]))
+            {
+                bin->free[i] = bin->free[--bin->count];
+                j = i + 1;
+            }
+            else
+            {
+                j++;
+            }
+        }
+    }
+}
+
+// --- PNG non compresso (deflate "stored"), letto da stb_image come tutti gli altri ---
+
+static uint32_t crc_table[256];
+
+static void crc_init(void)
+{
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const unsigned char *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_u32(unsigned char *out, uint32_t value)
+{
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static void write_chunk(FILE *file, const char *type, const unsigned char *data, size_t length)
+{
+    unsigned char word[4];
+    put_u32(word, (uint32_t)length);
+    fwrite(word, 1, 4, file);
+    fwrite(type, 1, 4, file);
+    if (length)
+        fwrite(data, 1, length, file);
+    uint32_t crc = crc_update(0xFFFFFFFFu, (const unsigned char *)type, 4);
+    crc = crc_update(crc, data, length) ^ 0xFFFFFFFFu;
+    put_u32(word, crc);
+    fwrite(word, 1, 4, file);
+}
+
+static int write_png(const char *path, const unsigned char *rgba, int width, int height)
+{
+    size_t rowBytes = (size_t)width * 4 + 1; // byte di filtro (0) + riga
+    size_t rawSize = rowBytes * height;
+    size_t blocks = (rawSize + 65534) / 65535;
+    unsigned char *zlib = malloc(2 + rawSize + blocks * 5 + 4);
+    unsigned char *raw = malloc(rawSize);
+    if (!zlib || !raw)
+    {
+        perror("Memory allocation failed");
+        free(zlib);
+        free(raw);
+        return 0;
+    }
+    for (int y = 0; y < height; y++)
+    {
+        raw[y * rowBytes] = 0;
+        memcpy(&raw[y * rowBytes + 1], &rgba[(size_t)y * width * 4], (size_t)width * 4);
+    }
+
+    size_t n = 0;
+    zlib[n++] = 0x78;
+    zlib[n++] = 0x01;
+    uint32_t a = 1, b = 0; // Adler-32
+    for (size_t offset = 0; offset < rawSize; offset += 65535)
+    {
+        size_t length = rawSize - offset < 65535 ? rawSize - offset : 65535;
+        zlib[n++] = offset + length == rawSize ? 1 : 0;
+        zlib[n++] = (unsigned char)length;
+        zlib[n++] = (unsigned char)(length >> 8);
+        zlib[n++] = (unsigned char)~length;
+        zlib[n++] = (unsigned char)(~length >> 8);
+        memcpy(&zlib[n], &raw[offset], length);
+        n += length;
+        for (size_t i = 0; i < length; i++)
+        {
+            a = (a + raw[offset + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    put_u32(&zlib[n], (b << 16) | a);
+    n += 4;
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        perror("Failed to open file");
+        free(zlib);
+        free(raw);
+        return 0;
+    }
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    unsigned char ihdr[13];
+    put_u32(ihdr, (uint32_t)width);
+    put_u32(ihdr + 4, (uint32_t)height);
+    ihdr[8] = 8;  // bit per canale
+    ihdr[9] = 6;  // RGBA
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // filtri standard
+    ihdr[12] = 0; // non interlacciato
+    fwrite(signature, 1, sizeof(signature), file);
+    write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+    write_chunk(file, "IDAT", zlib, n);
+    write_chunk(file, "IEND", NULL, 0);
+    int ok = fclose(file) == 0;
+    free(zlib);
+    free(raw);
+    return ok;
+}
+
+// Copia l'immagine nel layer e replica i bordi nel padding, contro il bleeding del filtro lineare
+static void blit(unsigned char *layer, int layerWidth, const Image *image, int x, int y, int padding)
+{
+    for (int dy = -padding; dy < image->height + padding; dy++)
+    {
+        int sy = dy < 0 ? 0 : (dy >= image->height ? image->height - 1 : dy);
+        for (int dx = -padding; dx < image->width + padding; dx++)
+        {
+            int sx = dx < 0 ? 0 : (dx >= image->width ? image->width - 1 : dx);
+            memcpy(&layer[((size_t)(y + dy) * layerWidth + (x + dx)) * 4],
+                   &image->pixels[((size_t)sy * image->width + sx) * 4], 4);
+        }
+    }
+}
+
+// Una regione va nella passata opaca solo se nessun suo texel ha alpha < 255
+static int image_opaque(const Image *image)
+{
+    size_t texels = (size_t)image->width * image->height;
+    for (size_t p = 0; p < texels; p++)
+    {
+        if (image->pixels[p * 4 + 3] != 255)
+            return 0;
+    }
+    return 1;
+}
+
+static int compare_images(const void *a, const void *b)
+{
+    // Prima le immagini col lato maggiore più lungo: MaxRects rende meglio così
+    const Image *ia = a, *ib = b;
+    int sa = ia->width > ia->height ? ia->width : ia->height;
+    int sb = ib->width > ib->height ? ib->width : ib->height;
+    if (sa != sb)
+        return sb - sa;
+    return ib->width * ib->height - ia->width * ia->height;
+}
+
+static void image_name(const char *path, char *name)
+{
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char *dot = strrchr(base, '.');
+    size_t length = dot ? (size_t)(dot - base) : strlen(base);
+    if (length >= ATLAS_NAME_LENGTH)
+        length = ATLAS_NAME_LENGTH - 1;
+    memcpy(name, base, length);
+    name[length] = '\0';
+}
+
+// Ogni regione è [layer, x, y, larghezza, altezza, opaca]
+static int write_json(const char *path, const Atlas *atlas)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        perror("Failed to open file");
+        return 0;
+    }
+    fprintf(file, "{\n  \"layerWidth\": %u,\n  \"layerHeight\": %u,\n  \"layers\": %u,\n  \"regions\": {\n",
+            atlas->layerWidth, atlas->layerHeight, atlas->layerCount);
+    for (uint32_t i = 0; i < atlas->regionCount; i++)
+    {
+        const AtlasRegion *r = &atlas->regions[i];
+        fprintf(file, "    \"%s\": [%u, %u, %u, %u, %u, %u]%s\n", r->name, r->layer, r->x, r->y, r->width, r->height,
+                (r->flags & ATLAS_REGION_OPAQUE) ? 1 : 0, i + 1 < atlas->regionCount ? "," : "");
+    }
+    fprintf(file, "  }\n}\n");
+    return fclose(file) == 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "uso: atlas_pack [-o dir] [-s layer_size] [-p padding] sprite.png ...\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *outDir = "assets/atlas";
+    int layerSize = 1024;
+    int padding = 1;
+
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; first++)
+    {
+        if (first + 1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if (strcmp(argv[first], "-o") == 0)
+            outDir = argv[++first];
+        else if (strcmp(argv[first], "-s") == 0)
+            layerSize = atoi(argv[++first]);
+        else if (strcmp(argv[first], "-p") == 0)
+            padding = atoi(argv[++first]);
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    int imageCount = argc - first;
+    if (imageCount <= 0 || layerSize <= 0 || layerSize > 16384 || padding < 0)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    Image *images = calloc(imageCount, sizeof(Image));
+    if (!images)
+    {
+        perror("Memory allocation failed");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < imageCount; i++)
+    {
+        Image *image = &images[i];
+        int channels;
+        image->path = argv[first + i];
+        image->pixels = stbi_load(image->path, &image->width, &image->height, &channels, STBI_rgb_alpha);
+        if (!image->pixels)
+        {
+            fprintf(stderr, "Impossibile caricare %s: %s\n", image->path, stbi_failure_reason());
+            return EXIT_FAILURE;
+        }
+        if (image->width + 2 * padding > layerSize || image->height + 2 * padding > layerSize)
+        {
+            fprintf(stderr, "%s (%dx%d) non entra in un layer %dx%d\n", image->path, image->width, image->height, layerSize, layerSize);
+            return EXIT_FAILURE;
+        }
+        image_name(image->path, image->name);
+    }
+    qsort(images, imageCount, sizeof(Image), compare_images);
+
+    Atlas atlas = {(uint32_t)layerSize, (uint32_t)layerSize, 0, (uint32_t)imageCount, (uint32_t)padding,
+                   calloc(imageCount, sizeof(AtlasRegion)), NULL};
+    MaxRects *bins = NULL;
+    unsigned char **layers = NULL;
+    if (!atlas.regions)
+    {
+        perror("Memory allocation failed");
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < imageCount; i++)
+    {
+        const Image *image = &images[i];
+        int width = image->width + 2 * padding;
+        int height = image->height + 2 * padding;
+
+        // Il layer dove il rettangolo sta meglio; uno nuovo se non entra da nessuna parte
+        Rect best = {0}, candidate;
+        long bestShort = 0, bestLong = 0, shortScore, longScore;
+        int bestLayer = -1;
+        for (uint32_t l = 0; l < atlas.layerCount; l++)
+        {
+            if (maxrects_find(&bins[l], width, height, &candidate, &shortScore, &longScore) &&
+                (bestLayer < 0 || shortScore < bestShort || (shortScore == bestShort && longScore < bestLong)))
+            {
+                best = candidate;
+                bestShort = shortScore;
+                bestLong = longScore;
+                bestLayer = (int)l;
+            }
+        }
+        if (bestLayer < 0)
+        {
+            bestLayer = (int)atlas.layerCount++;
+            bins = realloc(bins, atlas.layerCount * sizeof(MaxRects));
+            layers = realloc(layers, atlas.layerCount * sizeof(unsigned char *));
+            if (!bins || !layers)
+            {
+                perror("Memory allocation failed");
+                return EXIT_FAILURE;
+            }
+            maxrects_init(&bins[bestLayer], layerSize, layerSize);
+            layers[bestLayer] = calloc((size_t)layerSize * layerSize, 4);
+            if (!layers[bestLayer])
+            {
+                perror("Memory allocation failed");
+                return EXIT_FAILURE;
+            }
+            maxrects_find(&bins[bestLayer], width, height, &best, &bestShort, &bestLong);
+        }
+        maxrects_place(&bins[bestLayer], &best);
+        blit(layers[bestLayer], layerSize, image, best.x + padding, best.y + padding, padding);
+
+        AtlasRegion *region = &atlas.regions[i];
+        memcpy(region->name, image->name, sizeof(region->name));
+        region->layer = (uint16_t)bestLayer;
+        region->x = (uint16_t)(best.x + padding);
+        region->y = (uint16_t)(best.y + padding);
+        region->width = (uint16_t)image->width;
+        region->height = (uint16_t)image->height;
+        region->flags = image_opaque(image) ? ATLAS_REGION_OPAQUE : 0;
+    }
+
+    if (mkdir(outDir, 0755) != 0 && errno != EEXIST)
+    {
+        perror(outDir);
+        return EXIT_FAILURE;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/atlas.bin", outDir);
+    if (!atlas_save(&atlas, path))
+        return EXIT_FAILURE;
+    // atlas_save ordina per nome: i duplicati sono adiacenti e renderebbero ambigua atlas_find
+    for (uint32_t i = 1; i < atlas.regionCount; i++)
+    {
+        if (strcmp(atlas.regions[i - 1].name, atlas.regions[i].name) == 0)
+        {
+            fprintf(stderr, "Nome di regione duplicato: %s\n", atlas.regions[i].name);
+            remove(path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    crc_init();
+    long long usedArea = 0;
+    for (int i = 0; i < imageCount; i++)
+        usedArea += (long long)images[i].width * images[i].height;
+    for (uint32_t l = 0; l < atlas.layerCount; l++)
+    {
+        char layerPath[512];
+        atlas_layer_path(path, (int)l, layerPath, sizeof(layerPath));
+        if (!write_png(layerPath, layers[l], layerSize, layerSize))
+            return EXIT_FAILURE;
+    }
+    snprintf(path, sizeof(path), "%s/atlas.json", outDir);
+    if (!write_json(path, &atlas))
+        return EXIT_FAILURE;
+
+    printf("%d immagini in %u layer %dx%d, occupazione %.1f%%\n", imageCount, atlas.layerCount, layerSize, layerSize,
+           100.0 * usedArea / ((double)atlas.layerCount * layerSize * layerSize));
+
+    for (uint32_t l = 0; l < atlas.layerCount; l++)
+    {
+        free(bins[l].free);
+        free(layers[l]);
+    }
+    free(bins);
+    free(layers);
+    for (int i = 0; i < imageCount; i++)
+        stbi_image_free(images[i].pixels);
+    free(images);
+    atlas_free(&atlas);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+// texture_bake: riempie la cache delle texture (assets/cache) senza avviare il gioco.
+//
+//   texture_bake layer.png ...
+//
+// Per ogni PNG scrive i pixel RGBA8 con la catena di mip completa, come farebbe il primo
+// avvio; le voci ancora valide non vengono toccate. Vedi texture_cache.h.
+// Le pagine di assets/atlas hanno la catena accorciata dal padding, come nel loader.
+#include "texture_loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "uso: texture_bake layer.png ...\n");
+        return EXIT_FAILURE;
+    }
+
+    Atlas atlas;
+    bool useAtlas = atlas_load(&atlas, ATLAS_DEFAULT_PATH);
+
+    int failed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        TextureLayer layer;
+        memset(&layer, 0, sizeof(layer));
+        snprintf(layer.path, sizeof(layer.path), "%s", argv[i]);
+        for (uint32_t l = 0; useAtlas && l < atlas.layerCount; l++)
+        {
+            char pagePath[256];
+            atlas_layer_path(ATLAS_DEFAULT_PATH, (int)l, pagePath, sizeof(pagePath));
+            if (strcmp(pagePath, argv[i]) == 0)
+                layer.mipLimit = atlas_mip_levels(&atlas);
+        }
+        if (!texture_layer_load(&layer))
+        {
+            fprintf(stderr, "Impossibile caricare %s\n", argv[i]);
+            failed++;
+            continue;
+        }
+        printf("%s: %dx%d, %d livelli%s\n", argv[i], layer.width, layer.height, layer.mipLevels,
+               layer.cache.mapping ? " (già in cache)" : "");
+        texture_layer_free(&layer);
+    }
+    atlas_free(&atlas);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}